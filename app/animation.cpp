@@ -0,0 +1,358 @@
+/*
+ * Microvisor Clock Demo -- Display animation
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static uint8_t dropHalf(uint8_t glyph);
+static uint8_t riseHalf(uint8_t glyph);
+
+
+/**
+ * @brief Move a glyph's top half into the bottom half of the digit.
+ *
+ * @param glyph: The glyph's segments.
+ *
+ * @returns The segments shown.
+ */
+static uint8_t dropHalf(uint8_t glyph) {
+
+    // a -> g, f -> e, b -> c, g -> d
+    return ((glyph & 0x01) << 6) | ((glyph & 0x20) >> 1) | ((glyph & 0x02) << 1) | ((glyph & 0x40) >> 3);
+}
+
+
+/**
+ * @brief Move a glyph's bottom half into the top half of the digit.
+ *
+ * @param glyph: The glyph's segments.
+ *
+ * @returns The segments shown.
+ */
+static uint8_t riseHalf(uint8_t glyph) {
+
+    // g -> a, e -> f, c -> b, d -> g
+    return ((glyph & 0x40) >> 6) | ((glyph & 0x10) << 1) | ((glyph & 0x04) >> 1) | ((glyph & 0x08) << 3);
+}
+
+
+/**
+ * @brief Roll a digit over to a new glyph.
+ *
+ * @param inDigit: The digit: L-R, 0-3. Default: 0.
+ */
+DigitRoll::DigitRoll(uint32_t inDigit)
+    :digit(inDigit)
+{
+}
+
+
+/**
+ * @brief Set the glyphs to roll between.
+ *
+ * @param fromGlyph: The glyph shown now.
+ * @param toGlyph:   The glyph to show. Its decimal point stays lit throughout.
+ */
+void DigitRoll::set(uint8_t fromGlyph, uint8_t toGlyph) {
+
+    from = fromGlyph;
+    to = toGlyph;
+}
+
+
+/**
+ * @brief Render a frame of the roll to every panel: the old glyph
+ *        half out, then the new glyph half in, then the new glyph.
+ *
+ * @param display: The display panels.
+ * @param index:   The frame.
+ *
+ * @returns `false` once the new glyph is shown.
+ */
+bool DigitRoll::render(DisplayGroup& display, uint32_t index) {
+
+    uint8_t glyph = to;
+    if (index == 0) glyph = dropHalf(from) | (to & 0x80);
+    if (index == 1) glyph = riseHalf(to) | (to & 0x80);
+
+    for (uint32_t i = 0 ; i < display.size() ; ++i) display.panel(i).setGlyph(glyph, digit, false);
+    return (index < 2);
+}
+
+
+/**
+ * @brief Set the brightness levels to fade between.
+ *
+ * @param fromLevel: The current level, 0-15.
+ * @param toLevel:   The level to fade to, 0-15.
+ */
+void BrightnessFade::set(uint32_t fromLevel, uint32_t toLevel) {
+
+    from = fromLevel > 15 ? 15 : fromLevel;
+    to = toLevel > 15 ? 15 : toLevel;
+}
+
+
+/**
+ * @brief Step the brightness register of every panel one
+ *        level closer to the target level.
+ *
+ * @param display: The display panels.
+ * @param index:   The frame.
+ *
+ * @returns `false` once the target level is set.
+ */
+bool BrightnessFade::render(DisplayGroup& display, uint32_t index) {
+
+    const uint32_t steps = (from > to) ? from - to : to - from;
+    const uint32_t step = (index + 1 < steps) ? index + 1 : steps;
+    display.setBrightness(from > to ? from - step : from + step);
+    return (step < steps);
+}
+
+
+/**
+ * @brief Show a list of texts in turn.
+ *
+ * @param inKeyframes: The texts and how long to show them. Not copied.
+ * @param inCount:     The number of keyframes.
+ * @param inDoesLoop:  `true` to start again after the last keyframe,
+ *                     `false` to play them once. Default: `true`.
+ */
+TextKeyframes::TextKeyframes(const Keyframe* inKeyframes, uint32_t inCount, bool inDoesLoop)
+    :keyframes(inKeyframes),
+     count(inCount),
+     doesLoop(inDoesLoop)
+{
+}
+
+
+/**
+ * @brief Render the current keyframe's text to every panel.
+ *
+ * Text is rendered every frame, but unchanged frames are not sent.
+ *
+ * @param display: The display panels.
+ * @param index:   The frame.
+ *
+ * @returns `false` once the last frame of a non-looping list is shown.
+ */
+bool TextKeyframes::render(DisplayGroup& display, uint32_t index) {
+
+    if (count == 0) return false;
+
+    if (index == 0) {
+        current = 0;
+        currentStart = 0;
+    } else if (index - currentStart >= keyframes[current].frames) {
+        // Move on to the next keyframe
+        currentStart = index;
+        if (++current == count) current = 0;
+    }
+
+    for (uint32_t i = 0 ; i < display.size() ; ++i) display.panel(i).setText(keyframes[current].text);
+    return doesLoop || current + 1 < count || index - currentStart + 1 < keyframes[current].frames;
+}
+
+
+/**
+ * @brief Scroll a text across every panel.
+ *
+ * @param inText:          The text. Not copied.
+ * @param inFramesPerStep: Frames for which each step is shown. Default: 4.
+ */
+TextScroll::TextScroll(const char* inText, uint32_t inFramesPerStep)
+    :text(inText),
+     framesPerStep(inFramesPerStep > 0 ? inFramesPerStep : 1)
+{
+}
+
+
+/**
+ * @brief Render the scroll's current step to every panel,
+ *        moving the text on one digit every few frames.
+ *
+ * The colon is turned off while the text scrolls.
+ *
+ * @param display: The display panels.
+ * @param index:   The frame.
+ *
+ * @returns `false` once the text has left the display.
+ */
+bool TextScroll::render(DisplayGroup& display, uint32_t index) {
+
+    if (index == 0) scroller.start(text);
+    if (index % framesPerStep == 0) scroller.step();
+
+    for (uint32_t i = 0 ; i < display.size() ; ++i) {
+        scroller.render(display.panel(i));
+        display.panel(i).setColon(false);
+    }
+
+    return !scroller.isDone();
+}
+
+
+/**
+ * @brief Play animations on a display.
+ *
+ * @param inDisplay: Reference to the app's display panels.
+ */
+Animator::Animator(DisplayGroup& inDisplay)
+    :display(inDisplay)
+{
+}
+
+
+/**
+ * @brief Start an animation from its first frame, which is
+ *        rendered at the next call to `render()`. An animation
+ *        that is already playing starts again.
+ *
+ * @param animation: The animation. Not copied.
+ */
+void Animator::play(Animation& animation) {
+
+    if (count == 0) nextFrameTick = HAL_GetTick();
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        if (animations[i] == &animation) {
+            frameIndex[i] = 0;
+            return;
+        }
+    }
+
+    if (count == MAX_ANIMATIONS) {
+        LOG_ERROR(DISPLAY, "Too many animations");
+        return;
+    }
+
+    animations[count] = &animation;
+    frameIndex[count] = 0;
+    count++;
+}
+
+
+/**
+ * @brief Stop an animation, leaving its last frame in place.
+ *
+ * @param animation: The animation.
+ */
+void Animator::stop(Animation& animation) {
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        if (animations[i] == &animation) {
+            count--;
+            animations[i] = animations[count];
+            frameIndex[i] = frameIndex[count];
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Are any animations playing?
+ *
+ * @returns `true` if an animation is playing, otherwise `false`.
+ */
+bool Animator::isActive(void) const {
+
+    return (count > 0);
+}
+
+
+/**
+ * @brief Is an animation playing?
+ *
+ * @param animation: The animation.
+ *
+ * @returns `true` if it is playing, otherwise `false`.
+ */
+bool Animator::isPlaying(const Animation& animation) const {
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        if (animations[i] == &animation) return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Render the next frame of every animation into the display
+ *        buffers, then drop any that have finished. The caller
+ *        draws the display.
+ *
+ * The next frame falls due one frame period from now.
+ */
+void Animator::render(void) {
+
+    if (count == 0) return;
+
+    PROFILE_SCOPE(PROFILE_ZONE_ANIMATE);
+
+    const uint32_t startTick = HAL_GetTick();
+    for (uint32_t i = 0 ; i < count ; ) {
+        if (animations[i]->render(display, frameIndex[i]++)) {
+            ++i;
+        } else {
+            stop(*animations[i]);
+        }
+    }
+
+    stats.frames++;
+    if (HAL_GetTick() - startTick > FRAME_BUDGET_MS) stats.overruns++;
+    nextFrameTick = startTick + FRAME_PERIOD_MS;
+}
+
+
+/**
+ * @brief Can the next frame be played, within its budget,
+ *        before a deadline?
+ *
+ * @param deadlineTick: The HAL tick by which the frame must be done.
+ *
+ * @returns `true` if a frame is due before the deadline, otherwise `false`.
+ */
+bool Animator::fitsBefore(uint32_t deadlineTick) {
+
+    if (count == 0) return false;
+
+    if ((int32_t)(deadlineTick - nextFrameTick) < (int32_t)FRAME_BUDGET_MS) {
+        stats.skipped++;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Get the HAL tick at which the next frame is due.
+ *
+ * @returns The tick.
+ */
+uint32_t Animator::getNextFrameTick(void) const {
+
+    return nextFrameTick;
+}
+
+
+/**
+ * @brief Get the animator's frame counts.
+ *
+ * @returns The stats.
+ */
+AnimatorStats Animator::getStats(void) const {
+
+    return stats;
+}
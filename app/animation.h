@@ -0,0 +1,147 @@
+/*
+ * Microvisor Clock Demo -- Display animation
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _ANIMATION_HEADER_
+#define _ANIMATION_HEADER_
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    frames;             // Frames rendered
+    uint32_t    overruns;           // Frames that took longer than the budget
+    uint32_t    skipped;            // Frames not started because the next second was too close
+} AnimatorStats;
+
+// A step of a keyframed animation: show the text for a number of frames
+typedef struct {
+    const char* text;
+    uint32_t    frames;
+} Keyframe;
+
+
+/**
+    Something that changes the display over a number of frames. It
+    renders each frame into the display's buffers; the animator sends
+    the result. Animations are not copied, so must outlive their play.
+ */
+class Animation {
+
+    public:
+        virtual             ~Animation() = default;
+        // Render frame `index`, from 0. Returns `false` once the last frame is rendered
+        virtual bool        render(DisplayGroup& display, uint32_t index) = 0;
+};
+
+
+/**
+    Roll one digit over to a new glyph: the old glyph drops out
+    of the bottom of the digit as the new one drops in at the top.
+ */
+class DigitRoll : public Animation {
+
+    public:
+        explicit            DigitRoll(uint32_t inDigit = 0);
+        void                set(uint8_t fromGlyph, uint8_t toGlyph);
+        bool                render(DisplayGroup& display, uint32_t index) override;
+
+    private:
+        uint32_t            digit;
+        uint8_t             from = 0;
+        uint8_t             to = 0;
+};
+
+
+/**
+    Change every panel's brightness a step at a time.
+ */
+class BrightnessFade : public Animation {
+
+    public:
+        void                set(uint32_t fromLevel, uint32_t toLevel);
+        bool                render(DisplayGroup& display, uint32_t index) override;
+
+    private:
+        uint32_t            from = 15;
+        uint32_t            to = 15;
+};
+
+
+/**
+    Show a list of texts in turn, each for a set number of
+    frames, once or on a loop. Use it to blink a message.
+ */
+class TextKeyframes : public Animation {
+
+    public:
+                            TextKeyframes(const Keyframe* inKeyframes, uint32_t inCount, bool inDoesLoop = true);
+        bool                render(DisplayGroup& display, uint32_t index) override;
+
+    private:
+        const Keyframe*     keyframes;
+        uint32_t            count;
+        uint32_t            current = 0;        // The keyframe shown
+        uint32_t            currentStart = 0;   // The frame it was first shown at
+        bool                doesLoop;
+};
+
+
+/**
+    Scroll a text across every panel, once, from the right. The
+    text moves one digit every few frames.
+ */
+class TextScroll : public Animation {
+
+    public:
+        explicit            TextScroll(const char* inText, uint32_t inFramesPerStep = 4);
+        bool                render(DisplayGroup& display, uint32_t index) override;
+
+    private:
+        const char*         text;
+        uint32_t            framesPerStep;
+        TextScroller        scroller;
+};
+
+
+/**
+    Plays animations at a fixed frame rate, between the clock's
+    once-a-second updates of the time.
+ */
+class Animator {
+
+    public:
+        // Constants
+        static constexpr uint32_t FRAME_PERIOD_MS = 50;     // 20 frames per second
+        static constexpr uint32_t FRAME_BUDGET_MS = 5;      // Most time a frame should take
+        static constexpr uint32_t MAX_ANIMATIONS = 6;
+
+        // Constructor
+        explicit            Animator(DisplayGroup& inDisplay);
+        // Methods
+        void                play(Animation& animation);
+        void                stop(Animation& animation);
+        bool                isActive(void) const;
+        bool                isPlaying(const Animation& animation) const;
+        void                render(void);
+        bool                fitsBefore(uint32_t deadlineTick);
+        uint32_t            getNextFrameTick(void) const;
+        AnimatorStats       getStats(void) const;
+
+    private:
+        // Properties
+        DisplayGroup&       display;
+        Animation*          animations[MAX_ANIMATIONS] = {nullptr};
+        uint32_t            frameIndex[MAX_ANIMATIONS] = {0};
+        uint32_t            count = 0;
+        uint32_t            nextFrameTick = 0;
+        AnimatorStats       stats = {0, 0, 0};
+};
+
+
+#endif  // _ANIMATION_HEADER_
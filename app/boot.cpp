@@ -0,0 +1,92 @@
+/*
+ * Microvisor Clock Demo -- Boot namespace
+ *
+ * Timestamps the start-up phases and reports them in one log
+ * line, so time to first display can be tracked from build to
+ * build. Times are microseconds from `BOOT_PHASE::START`.
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t  PHASE_COUNT = (uint32_t)BOOT_PHASE::COUNT;
+
+
+/*
+ * GLOBALS
+ */
+static          uint64_t    phaseUs[PHASE_COUNT] = { 0 };
+static          uint32_t    markedPhases = 0;
+static          bool        reported = false;
+
+
+namespace Boot {
+
+/**
+ * @brief Record when a phase was reached. Only the
+ *        first time a phase is reached is recorded.
+ *
+ * @param phase: The phase.
+ */
+void mark(BOOT_PHASE phase) {
+
+    const uint32_t bit = 1UL << (uint32_t)phase;
+    if (markedPhases & bit) return;
+
+    uint64_t now = 0;
+    mvGetMicroseconds(&now);
+    phaseUs[(uint32_t)phase] = now;
+    markedPhases |= bit;
+}
+
+
+/**
+ * @brief Get when a phase was reached.
+ *
+ * @param phase: The phase.
+ *
+ * @returns Microseconds from the start of `main()`,
+ *          or zero if the phase hasn't been reached.
+ */
+uint32_t elapsedUs(BOOT_PHASE phase) {
+
+    if (!(markedPhases & (1UL << (uint32_t)phase))) return 0;
+    const uint64_t elapsed = phaseUs[(uint32_t)phase] - phaseUs[(uint32_t)BOOT_PHASE::START];
+    return elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+}
+
+
+/**
+ * @brief Log the phase timings once, when the network is up
+ *        and the first config fetch has completed, or has had
+ *        long enough to.
+ *
+ * Call this regularly from the main loop.
+ */
+void report(void) {
+
+    constexpr uint64_t CONFIG_WAIT_US = 10 * 1000 * 1000;
+    if (reported || !(markedPhases & (1UL << (uint32_t)BOOT_PHASE::NETWORK_ONLINE))) return;
+
+    if (!(markedPhases & (1UL << (uint32_t)BOOT_PHASE::CONFIG_FETCHED))) {
+        uint64_t now = 0;
+        mvGetMicroseconds(&now);
+        if (now - phaseUs[(uint32_t)BOOT_PHASE::NETWORK_ONLINE] < CONFIG_WAIT_US) return;
+    }
+
+    reported = true;
+    LOG_DEBUG(APP, "Boot (us): hal %lu, i2c %lu, prefs %lu, display %lu, network %lu, loop %lu, time %lu, online %lu, config %lu",
+              elapsedUs(BOOT_PHASE::HAL_READY), elapsedUs(BOOT_PHASE::I2C_READY), elapsedUs(BOOT_PHASE::PREFS_LOADED),
+              elapsedUs(BOOT_PHASE::DISPLAY_READY), elapsedUs(BOOT_PHASE::NETWORK_REQUESTED), elapsedUs(BOOT_PHASE::LOOP_STARTED),
+              elapsedUs(BOOT_PHASE::TIME_SHOWN), elapsedUs(BOOT_PHASE::NETWORK_ONLINE), elapsedUs(BOOT_PHASE::CONFIG_FETCHED));
+}
+
+
+}   // namespace Boot
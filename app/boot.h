@@ -0,0 +1,43 @@
+/*
+ * Microvisor Clock Demo -- Boot namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _BOOT_HEADER_
+#define _BOOT_HEADER_
+
+
+/*
+ * ENUMERATIONS
+ */
+// Start-up milestones, in the order they're usually reached
+enum class BOOT_PHASE: uint32_t {
+    START = 0,              // `main()` entered
+    HAL_READY,              // HAL and system clock set up
+    I2C_READY,              // I2C bus up and display probed
+    PREFS_LOADED,           // Saved prefs read from flash
+    DISPLAY_READY,          // Display on and showing SYNC
+    NETWORK_REQUESTED,
+    LOOP_STARTED,           // Clock loop entered
+    TIME_SHOWN,             // First time drawn from the RTC
+    NETWORK_ONLINE,
+    CONFIG_FETCHED,         // First config fetch completed
+    COUNT
+};
+
+
+/*
+ * PROTOTYPES
+ */
+namespace Boot {
+
+    void        mark(BOOT_PHASE phase);
+    uint32_t    elapsedUs(BOOT_PHASE phase);
+    void        report(void);
+}
+
+
+#endif  // _BOOT_HEADER_
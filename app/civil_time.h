@@ -0,0 +1,174 @@
+/*
+ * Microvisor Clock Demo -- Integer-only calendar conversions
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Converts between Unix epoch seconds and civil (proleptic
+ * Gregorian, UTC) dates without `gmtime()`, `strftime()` or any
+ * other newlib time machinery. The day/date algorithms are from
+ * Howard Hinnant's 'chrono-Compatible Low-Level Date Algorithms'.
+ *
+ * Usable from C and C++; in C++ every conversion is `constexpr`.
+ *
+ */
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+#define CIVIL_CONSTEXPR constexpr
+#else
+#define CIVIL_CONSTEXPR
+#endif
+
+
+/*
+ * CONSTANTS
+ */
+#define CIVIL_SECONDS_PER_DAY               86400
+#define CIVIL_TIMESTAMP_LEN                 19
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    int32_t     year;       // Full year, eg. 2024
+    uint32_t    month;      // 1-12
+    uint32_t    day;        // 1-31
+    uint32_t    hour;       // 0-23
+    uint32_t    minute;     // 0-59
+    uint32_t    second;     // 0-59
+    uint32_t    weekday;    // 0 (Sunday) to 6 (Saturday)
+} CivilTime;
+
+
+/**
+ * @brief Count the days from 1970-01-01 to the specified date.
+ *
+ * @param year:  Full year, eg. 2024.
+ * @param month: 1-12.
+ * @param day:   1-31.
+ *
+ * @returns The number of days; negative for dates before 1970.
+ */
+static inline CIVIL_CONSTEXPR int32_t days_from_civil(int32_t year, uint32_t month, uint32_t day) {
+
+    year -= (month <= 2 ? 1 : 0);
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - era * 400);
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+
+/**
+ * @brief Convert a count of days since 1970-01-01 to a date.
+ *
+ * @param days:  The day count.
+ * @param year:  Pointer to the year to set.
+ * @param month: Pointer to the month (1-12) to set.
+ * @param day:   Pointer to the day of the month (1-31) to set.
+ */
+static inline CIVIL_CONSTEXPR void civil_from_days(int32_t days, int32_t* year, uint32_t* month, uint32_t* day) {
+
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(days - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (int32_t)yoe + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
+
+/**
+ * @brief Get the day of the week for a count of days since 1970-01-01.
+ *
+ * @param days: The day count.
+ *
+ * @returns The day of the week: 0 (Sunday) to 6 (Saturday).
+ */
+static inline CIVIL_CONSTEXPR uint32_t weekday_from_days(int32_t days) {
+
+    return (uint32_t)(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+
+/**
+ * @brief Break down a Unix epoch time into its UTC date and time.
+ *
+ * @param secs: Seconds since 1970-01-01 00:00:00 UTC.
+ *
+ * @returns The civil date and time.
+ */
+static inline CIVIL_CONSTEXPR CivilTime civil_time_from_epoch(int64_t secs) {
+
+    int32_t days = (int32_t)(secs / CIVIL_SECONDS_PER_DAY);
+    int32_t rem = (int32_t)(secs % CIVIL_SECONDS_PER_DAY);
+    if (rem < 0) {
+        rem += CIVIL_SECONDS_PER_DAY;
+        days -= 1;
+    }
+
+    CivilTime result = { 0, 0, 0, 0, 0, 0, 0 };
+    civil_from_days(days, &result.year, &result.month, &result.day);
+    result.hour = (uint32_t)rem / 3600;
+    result.minute = ((uint32_t)rem / 60) % 60;
+    result.second = (uint32_t)rem % 60;
+    result.weekday = weekday_from_days(days);
+    return result;
+}
+
+
+/**
+ * @brief Convert a UTC date and time to a Unix epoch time.
+ *
+ * @param time: Pointer to the civil date and time. `weekday` is ignored.
+ *
+ * @returns Seconds since 1970-01-01 00:00:00 UTC.
+ */
+static inline CIVIL_CONSTEXPR int64_t epoch_from_civil_time(const CivilTime* time) {
+
+    return (int64_t)days_from_civil(time->year, time->month, time->day) * CIVIL_SECONDS_PER_DAY
+           + time->hour * 3600 + time->minute * 60 + time->second;
+}
+
+
+/**
+ * @brief Write a civil time as "YYYY-MM-DD HH:MM:SS".
+ *
+ * @param time:   Pointer to the civil date and time.
+ * @param buffer: Destination for at least CIVIL_TIMESTAMP_LEN characters.
+ *                No NUL terminator is written.
+ */
+static inline void civil_time_format(const CivilTime* time, char* buffer) {
+
+    const uint32_t year = (uint32_t)time->year % 10000;
+    const uint32_t values[6] = { year / 100, year % 100, time->month, time->day, time->hour, time->minute };
+    const char separators[6] = { 0, 0, '-', '-', ' ', ':' };
+
+    for (uint32_t i = 0 ; i < 6 ; ++i) {
+        if (separators[i] != 0) *buffer++ = separators[i];
+        *buffer++ = (char)('0' + values[i] / 10);
+        *buffer++ = (char)('0' + values[i] % 10);
+    }
+
+    *buffer++ = ':';
+    *buffer++ = (char)('0' + time->second / 10);
+    *buffer = (char)('0' + time->second % 10);
+}
+
+
+#endif  // CIVIL_TIME_H
@@ -9,56 +9,68 @@
 #include "main.h"
 
 
+/*
+ * CONSTANTS
+ */
+// Blink SYNC once a second until the RTC has been set
+static const Keyframe SYNC_KEYFRAMES[2] = {
+    { "SYNC", 1000 / Animator::FRAME_PERIOD_MS / 2 },
+    { "",     1000 / Animator::FRAME_PERIOD_MS / 2 }
+};
+
+// Scrolled across the display when the network connection drops
+static const char OFFLINE_TEXT[] = "no net";
+
+
 /**
  * @brief Basic driver for HT16K33-based display.
  *
  * @param inPrefs:   Reference to the app's preferences data.
- * @param inDisplay: Reference to the app's display instance.
- * @param gotPrefs:  Have we loaded clock settings yet?
+ * @param inDisplay: Reference to the app's display panels.
  */
-Clock::Clock(const Prefs& inPrefs, const HT16K33_Segment& inDisplay, const bool gotPrefs)
-    :prefs(inPrefs),
+Clock::Clock(Prefs& inPrefs, DisplayGroup& inDisplay)
+    :shownBrightness(inPrefs.brightness),
+     prefs(inPrefs),
      display(inDisplay),
-     receivedPrefs(gotPrefs)
-{}
+     animator(inDisplay),
+     syncBlink(SYNC_KEYFRAMES, 2),
+     offlineScroll(OFFLINE_TEXT)
+{
+    setZone();
+    animator.play(syncBlink);
+}
 
 
 /**
- * @brief Set the current time from the STM32U5 RTC
+ * @brief Set the current local time from the STM32U5 RTC
  *        via Microvisor.
  *
  * @returns `true` if the time was set, otherwise `false`.
  */
 bool Clock::setTimeFromRTC(void) {
 
-    static char timestamp[65] = {0};
-    static struct tm timeStore;
+    PROFILE_SCOPE(PROFILE_ZONE_TIME_FETCH);
+
+    // 2024-01-01 00:00:00 UTC: any earlier and the RTC has not been set
+    constexpr uint64_t MIN_VALID_USEC = 1704067200ULL * 1000000ULL;
     uint64_t usec = 0;
-    uint32_t now_year;
-    uint32_t now_month;
-    uint32_t now_day;
-    uint32_t now_hour;
-    uint32_t now_mins;
-    uint32_t now_secs;
-
-    if (mvGetWallTime(&usec) == MV_STATUS_OKAY) {
-        // Get the time in seconds
-        const time_t secs = (time_t)usec / 1000000;
-
-        // Write time string as "2022-05-10 13:30:58"
-        if (strftime(timestamp, 64, "%F %T", gmtime_r(&secs, &timeStore)) > 0) {
-            // Convert the hour, minute and second values back
-            int result = sscanf(timestamp, "%lu-%lu-%lu %lu:%lu:%lu", &now_year, &now_month, &now_day, &now_hour, &now_mins, &now_secs);
-            if (result == 6) {
-                year = now_year;
-                month = now_month;
-                day = now_day;
-                hour = now_hour;
-                minutes = now_mins;
-                seconds = now_secs;
-                return true;
-            }
-        }
+
+    if (mvGetWallTime(&usec) == MV_STATUS_OKAY && usec >= MIN_VALID_USEC) {
+        // Apply the UTC offset, observing DST if allowed,
+        // then break the time down into its components
+        const auto utc = (int64_t)(usec / 1000000);
+        PROFILE_BEGIN(PROFILE_ZONE_DST);
+        const int32_t offset = prefs.bst ? zone.offset(utc) : zone.standardOffset();
+        PROFILE_END(PROFILE_ZONE_DST);
+        const CivilTime now = civil_time_from_epoch(utc + offset);
+        year = (uint32_t)now.year;
+        month = now.month;
+        day = now.day;
+        hour = now.hour;
+        minutes = now.minute;
+        seconds = now.second;
+        millis = (uint32_t)((usec / 1000) % 1000);
+        return true;
     }
 
     return false;
@@ -70,177 +82,237 @@ bool Clock::setTimeFromRTC(void) {
  */
 [[noreturn]] void Clock::loop(void) {
 
-    constexpr uint32_t CONFIG_ACQUIRE_PERIOD_MINS = 4;
-
-    // Update brightness
-    display.setBrightness(prefs.brightness);
-
     while (true) {
-        // Check the time
-        setTimeFromRTC();
-
-        // Update display hour for DST, if allowed
-        uint32_t displayHour = hour;
-        if (prefs.bst && isBST()) displayHour = (displayHour + 1) % 24;
-        bool isPM = (displayHour > 11);
-
-        // Calculate and set the hours digits
-        if (!prefs.mode) {
-            if (isPM) displayHour -= 12;
-            if (displayHour == 0) displayHour = 12;
-        }
-
-        // Display the hour
-        // The decimal point by the first digit is used to indicate
-        // connection status (lit if the clock is disconnected)
-        uint32_t netState = Config::Network::getState();
-        auto decimal = (uint8_t)(bcd(displayHour) & 0xFF);
-        display.setNumber(decimal & 0x0F, 1, false);
-        if (!prefs.mode && displayHour < 10) {
-            // Show a blank space in the first digit
-            display.setGlyph(0, 0, (netState != (uint32_t)NET_STATE::ONLINE));
-        } else {
-            display.setNumber((decimal >> 4) & 0x0F, 0, (netState != (uint32_t)NET_STATE::ONLINE));
-        }
-
-        // Display the minute
-        // The decimal point by the last digit is used to indicate AM/PM,
-        // but only for the 12-hour clock mode (mode == False)
-        decimal = (uint8_t)(bcd(minutes) & 0xFF);
-        display.setNumber((decimal >> 4) & 0x0F, 2, false);
-        display.setNumber(decimal & 0x0F, 3, (prefs.mode ? false : isPM));
-
-        // Set the colon and present the display
-        if (prefs.colon) {
-            // Show the colon, either solid or flash
-            if (prefs.flash) {
-                // Show the colon every two seconds, for a second
-                display.setColon(seconds % 2 == 0);
-                // Flash the NDB LED in sync
-                if (prefs.led) HAL_GPIO_WritePin(LED_GPIO_BANK, LED_GPIO_PIN, seconds % 2 == 0 ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            } else {
-                // Illuminate the colon permanently
-                display.setColon(prefs.colon);
-            }
-        }
-
-        // Tell the display driver to update the LED
-        display.draw();
-
-        // Reload prefs if we haven't done so yet
-        if (netState == (uint32_t)NET_STATE::ONLINE && !receivedPrefs && minutes != 0 && minutes % CONFIG_ACQUIRE_PERIOD_MINS == 0) {
-            receivedPrefs = Config::getPrefs(prefs);
-            if (receivedPrefs) {
-                // Update brightness
-                display.setBrightness(prefs.brightness);
-                server_log("Clock settings retrieved");
-            } else {
-                server_error("Clock settings not retrieved (%u)", minutes);
-            }
-        }
-
-        // Reset the prefs get flag periodically
-        if (minutes != 0 && minutes % 15 == 0) {
-            receivedPrefs = false;
-        }
+        // Sleep until the next second boundary, or until
+        // a notification needs attention. Animations play
+        // in between, but never hold up the boundary
+        const uint32_t deadlineTick = HAL_GetTick() + tick();
+        profile_report();
+        if (playAnimations(deadlineTick)) Idle::waitUntil(deadlineTick);
     }
 }
 
 
 /**
- * @brief Convert an integer to a binary coded decimal representation.
+ * @brief Play animation frames, at the animator's frame rate,
+ *        for as long as they can be finished before a deadline.
  *
- * @param rawInt: The source value.
+ * @param deadlineTick: The HAL tick of the next second boundary.
  *
- * @returns The BCD encoding.
+ * @returns `true` if there is time left to wait out, or `false`
+ *          if a notification cut the wait short.
  */
-uint32_t Clock::bcd(uint32_t rawInt) const {
+bool Clock::playAnimations(uint32_t deadlineTick) {
 
-    uint32_t result = 0;
-    uint32_t shift = 0;
+    while (animator.fitsBefore(deadlineTick)) {
+        const uint32_t frameTick = animator.getNextFrameTick();
+        Idle::waitUntil(frameTick);
+        if ((int32_t)(frameTick - HAL_GetTick()) > 0) return false;
 
-    while (rawInt) {
-        result += ((rawInt % 10) << shift);
-        rawInt = rawInt / 10;
-        shift += 4;
+        animator.render();
+        display.draw();
     }
 
-    return (result & 0xFF);
+    return true;
 }
 
 
 /**
- * @brief Are we in UK daylight savings time?
+ * @brief Perform one pass of the clock: handle events, advance
+ *        any settings fetch and update the display.
  *
- * @returns `true` if DST is active, otherwise `false`.
+ * @returns The number of milliseconds until the next pass is due.
  */
-bool Clock::isBST(void) const {
+uint32_t Clock::tick(void) {
+
+    PROFILE_SCOPE(PROFILE_ZONE_TICK);
+
+    constexpr uint32_t CONFIG_REFRESH_PERIOD_MINS = 15;
+    constexpr uint32_t STATS_REPORT_PERIOD_MINS = 60;
+
+    // Handle any notifications that arrived while we slept,
+    // then track the network connection
+    Notifications::dispatch();
+    Config::Network::service();
+
+    // Advance any settings fetch, and apply any settings that changed.
+    // Mode, DST and colon flashing take effect when the display is next drawn
+    const uint32_t changes = Config::service(prefs);
+    if (changes != (uint32_t)PREFS_CHANGE::NONE) {
+        if (changes & (uint32_t)PREFS_CHANGE::BRIGHTNESS) {
+            fade.set(shownBrightness, prefs.brightness);
+            shownBrightness = prefs.brightness;
+            animator.play(fade);
+        }
+
+        if (changes & (uint32_t)PREFS_CHANGE::TZ) setZone();
+        if ((changes & (uint32_t)PREFS_CHANGE::LED) && !prefs.led) HAL_GPIO_WritePin(LED_GPIO_BANK, LED_GPIO_PIN, GPIO_PIN_RESET);
+        LOG_DEBUG(CLOCK, "Clock settings applied (changes: 0x%02lx)", changes);
+        Store::save(prefs);
+    }
+
+    // Check the time. If the RTC hasn't been set yet, leave
+    // the current display in place until it has been
+    if (!setTimeFromRTC()) return 1000;
 
-    return bstCheck();
+    // The first time the time is shown, it replaces SYNC
+    if (!isTimeShown) animator.stop(syncBlink);
+
+    PROFILE_BEGIN(PROFILE_ZONE_RENDER);
+    uint8_t shownGlyphs[4];
+    for (uint32_t i = 0 ; i < 4 ; ++i) shownGlyphs[i] = display.panel(0).getDigit(i);
+    displayHour = hour;
+    isPM = (displayHour > 11);
+
+    // Calculate and set the hours digits
+    if (!prefs.mode) {
+        if (isPM) displayHour -= 12;
+        if (displayHour == 0) displayHour = 12;
+    }
+
+    // Every panel shows the time
+    const bool isOnline = (Config::Network::getState() == (uint32_t)NET_STATE::ONLINE);
+    for (uint32_t i = 0 ; i < display.size() ; ++i) render(display.panel(i), isOnline);
+
+    // Say so when the connection drops. The time
+    // returns once the text has scrolled off
+    if (wasOnline && !isOnline) animator.play(offlineScroll);
+    wasOnline = isOnline;
+
+    // Flash the NDB LED in sync with the colon
+    if (prefs.colon && prefs.flash && prefs.led) HAL_GPIO_WritePin(LED_GPIO_BANK, LED_GPIO_PIN, seconds % 2 == 0 ? GPIO_PIN_SET : GPIO_PIN_RESET);
+
+    // Roll over the digits that change with the minute, unless text is scrolling
+    if (isTimeShown && minutes != lastMinute && !animator.isPlaying(offlineScroll)) {
+        for (uint32_t i = 0 ; i < 4 ; ++i) {
+            const uint8_t glyph = display.panel(0).getDigit(i);
+            if (glyph == shownGlyphs[i]) continue;
+            rolls[i].set(shownGlyphs[i], glyph);
+            animator.play(rolls[i]);
+        }
+    }
+
+    isTimeShown = true;
+    PROFILE_END(PROFILE_ZONE_RENDER);
+
+    // Apply the first frame of any animation, then tell
+    // the display driver to update the LEDs
+    animator.render();
+    display.draw();
+
+    // Report how long it took to get the time on the display
+    // once there's a network to report it over
+    Boot::mark(BOOT_PHASE::TIME_SHOWN);
+    Boot::report();
+
+    // Per-minute housekeeping: refresh the settings
+    // and report usage periodically
+    if (minutes != lastMinute) {
+        if (minutes % CONFIG_REFRESH_PERIOD_MINS == 0) Config::requestPrefs();
+        if (minutes % STATS_REPORT_PERIOD_MINS == 0) reportStats();
+        lastMinute = minutes;
+    }
+
+    return 1000 - millis;
 }
 
 
 /**
- * @brief Are we in UK daylight savings time?
+ * @brief Render the current time to one display panel.
  *
- * @returns `true` if DST is active, otherwise `false`.
+ * @param panel:    The panel.
+ * @param isOnline: Is the network connected?
  */
-bool Clock::bstCheck(void) const {
+void Clock::render(HT16K33_Segment& panel, bool isOnline) {
+
+    // Display the hour
+    // The decimal point by the first digit is used to indicate
+    // connection status (lit if the clock is disconnected)
+    auto decimal = (uint8_t)(bcd(displayHour) & 0xFF);
+    panel.setNumber(decimal & 0x0F, 1, false);
+    if (!prefs.mode && displayHour < 10) {
+        // Show a blank space in the first digit
+        panel.setGlyph(0, 0, !isOnline);
+    } else {
+        panel.setNumber((decimal >> 4) & 0x0F, 0, !isOnline);
+    }
 
-    if (month > 3 && month < 10) return true;
+    // Display the minute
+    // The decimal point by the last digit is used to indicate AM/PM,
+    // but only for the 12-hour clock mode (mode == False)
+    decimal = (uint8_t)(bcd(minutes) & 0xFF);
+    panel.setNumber((decimal >> 4) & 0x0F, 2, false);
+    panel.setNumber(decimal & 0x0F, 3, (prefs.mode ? false : isPM));
 
-    if (month == 3) {
-        // BST starts on the last Sunday of March
-        for (uint32_t i = 31 ; i > 24 ; --i) {
-            if ((dayOfWeek(i, 3, (int)year) == 0) && (day >= i)) return true;
-        }
-    }
+    // Set the colon: off, solid, or lit every two seconds, for a second
+    panel.setColon(prefs.colon && (!prefs.flash || seconds % 2 == 0));
+}
 
-    if (month == 10) {
-        // BST ends on the last Sunday of October
-        for (uint32_t i = 31 ; i > 24 ; --i) {
-            if ((dayOfWeek(i, 10, (int)year) == 0) && (day < i)) return true;
-        }
+
+/**
+ * @brief Set the timezone from the prefs' POSIX TZ string,
+ *        falling back to UK time if there isn't a valid one.
+ */
+void Clock::setZone(void) {
+
+    DST::RuleSet rules;
+    if (prefs.tz[0] != 0 && DST::parseTZ(prefs.tz, rules)) {
+        zone = DST::Zone(rules);
+        LOG_DEBUG(CLOCK, "Timezone set: %s", prefs.tz);
+        return;
     }
 
-    return false;
+    if (prefs.tz[0] != 0) LOG_ERROR(CLOCK, "Invalid timezone: %s", prefs.tz);
+    zone = DST::Zone(DST::RULES::UK);
 }
 
 
 /**
- * @brief Determine the day of the week for a given day, month and year, using
- *        Zeller's Rule (see http://mathforum.org/dr.math/faq/faq.calendar.html).
- *
- * @param aDay:   The day of the month (1-31).
- * @param aMonth: A month (1-12).
- * @param aYear:  A year (including the century, ie. '2019' not '19').
- *
- * @returns The day of the week: 0 (Monday) to 6 (Sunday).
+ * @brief Log CPU, display bus and config fetch usage.
  */
-uint32_t Clock::dayOfWeek(int aDay, int aMonth, int aYear) const {
-
-    aMonth -= 2;
-    if (aMonth < 1) aMonth += 12;
-    const uint32_t century = aYear / 100;
-    aYear -= (century * 100);
-    aYear -= (month > 10 ? 1 : 0);
-
-    int dow = aDay + ((13 * aMonth - 1) / 5) + aYear + (int)(year / 4) + (int)(century / 4) - (2 * century);
-    dow %= 7;
-    if (dow < 0) dow += 7;
-    return (uint32_t)dow;
+void Clock::reportStats(void) {
+
+    const IdleStats idle = Idle::getStats();
+    const FetchStats fetch = Config::getFetchStats();
+    LOG_DEBUG(CLOCK, "CPU busy %lu%%, %lu wakeups/s. Display panels: %lu, frames skipped: %lu, bytes sent: %lu in %lu transactions",
+               idle.busyPercent, idle.wakeupsPerSecond, display.size(), display.getFramesSkipped(), display.getBytesSent(), display.getTransactions());
+    const AnimatorStats frames = animator.getStats();
+    LOG_DEBUG(CLOCK, "Animation frames: %lu, over budget: %lu, skipped for the time: %lu",
+               frames.frames, frames.overruns, frames.skipped);
+    const NotificationStats notes = Notifications::getStats();
+    LOG_DEBUG(CLOCK, "Config fetches: %lu (%lu unchanged), failures: %lu, latency %lums (min %lums, max %lums)",
+               fetch.fetches, fetch.unchanged, fetch.failures, fetch.lastMs, fetch.fetches > 0 ? fetch.minMs : 0, fetch.maxMs);
+    LOG_DEBUG(CLOCK, "Notifications: %lu, overruns: %lu, unknown tags: %lu, latency %luus (max %luus)",
+               notes.dispatched, notes.overruns, notes.unknownTags, notes.lastLatencyUs, notes.maxLatencyUs);
+    const HeapStats heap = Heap::getStats();
+    if (heap.allocationsAfterBoot > 0) {
+        LOG_ERROR(CLOCK, "Heap used after boot: %lu allocations, %lu bytes", heap.allocationsAfterBoot, heap.bytesAfterBoot);
+    } else {
+        LOG_DEBUG(CLOCK, "Heap allocations: %lu, none after boot", heap.allocations);
+    }
+#if ENABLE_UART_DEBUGGING == true
+    LOG_DEBUG(CLOCK, "UART log bytes dropped: %lu", log_uart_get_dropped_bytes());
+#endif
 }
 
 
 /**
- * @brief Is the specified year a leap year?
+ * @brief Convert an integer to a binary coded decimal representation.
  *
- * @param aYear: A year (including the century, ie. '2019' not '19').
+ * @param rawInt: The source value.
  *
- * @returns `true` if the year is a leap year, otherwise `false`.
+ * @returns The BCD encoding.
  */
-bool Clock::isLeapYear(uint32_t aYear) const {
+uint32_t Clock::bcd(uint32_t rawInt) {
 
-    if ((aYear % 4 == 0) && (aYear % 100 > 0 || aYear % 400 == 0)) return true;
-    return false;
+    uint32_t result = 0;
+    uint32_t shift = 0;
+
+    while (rawInt) {
+        result += ((rawInt % 10) << shift);
+        rawInt = rawInt / 10;
+        shift += 4;
+    }
+
+    return (result & 0xFF);
 }
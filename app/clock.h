@@ -17,6 +17,7 @@ typedef struct {
     bool        flash;      // Flash the colon separator if it's being shown
     bool        led;        // Flash the LED in sync with the colon
     uint32_t    brightness; // Display brightness (1-15)
+    char        tz[64];     // POSIX TZ string, eg. "CET-1CEST,M3.5.0,M10.5.0/3". Empty for UK time
 } Prefs;
 
 
@@ -24,29 +25,42 @@ class Clock {
 
     public:
         // Constructor
-        Clock(const Prefs& inPrefs, const HT16K33_Segment& inDisplay, const bool gotPrefs);
+        Clock(Prefs& inPrefs, DisplayGroup& inDisplay);
         // Methods
         bool                setTimeFromRTC(void);
+        uint32_t            tick(void);
         [[noreturn]] void   loop(void);
+        static uint32_t     bcd(uint32_t bin_value);
 
     private:
         //Methods
-        uint32_t            bcd(uint32_t bin_value) const;
-        bool                isBST(void) const;
-        bool                bstCheck(void) const;
-        uint32_t            dayOfWeek(int a_day, int a_month, int a_year) const;
-        bool                isLeapYear(uint32_t a_year) const;
+        void                setZone(void);
+        void                render(HT16K33_Segment& panel, bool isOnline);
+        bool                playAnimations(uint32_t deadlineTick);
+        void                reportStats(void);
         // Properties
         uint32_t            hour = 0;
         uint32_t            minutes = 0;
         uint32_t            seconds = 0;
+        uint32_t            millis = 0;
+        uint32_t            lastMinute = 60;
+        DST::Zone           zone;
         uint32_t            year = 0;
         uint32_t            month = 0;
         uint32_t            day = 0;
+        uint32_t            displayHour = 0;
+        bool                isPM = false;
+        bool                isTimeShown = false;
+        bool                wasOnline = false;
+        uint32_t            shownBrightness;
         // Following set by constructor
-        Prefs               prefs;
-        HT16K33_Segment     display;
-        bool                receivedPrefs;
+        Prefs&              prefs;              // Owned by main(), as is the display
+        DisplayGroup&       display;
+        Animator            animator;
+        DigitRoll           rolls[4] = { DigitRoll(0), DigitRoll(1), DigitRoll(2), DigitRoll(3) };
+        BrightnessFade      fade;
+        TextKeyframes       syncBlink;
+        TextScroll          offlineScroll;
 };
 
 
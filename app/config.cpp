@@ -10,135 +10,413 @@
 
 
 /*
- * FORWARD DECLARATIONS
+ * GLOBALS
  */
-#ifdef __cplusplus
-extern "C" void TIM8_BRK_IRQHandler(void);
-#endif
+static          Handles         handles = { nullptr, nullptr };
+static          bool            receivedConfig = false;
+static          bool            networkChanged = false;
+
+// Network connection state
+static          uint32_t        networkState = (uint32_t)NET_STATE::OFFLINE;
+static          uint32_t        connectStartTick = 0;
+static          uint32_t        networkPollTick = 0;
+static          uint32_t        networkRetryTick = 0;
+static          uint32_t        networkBackoffMs = 0;
+
+// Config fetch state
+static          FETCH_STATE     fetchState = FETCH_STATE::IDLE;
+static          uint32_t        stateTick = 0;
+static          uint32_t        backoffMs = 0;
+static          bool            fetchFailed = false;
+static          FetchStats      fetchStats = { 0, 0, 0, UINT32_MAX, 0, 0 };
+
+// Fetched config values. Map the extent of `prefsValue`
+// to the bytesize of your JSON
+static          uint8_t         prefsValue[257] = {0};
+static          uint8_t         tzValue[sizeof(Prefs::tz)] = {0};
+
+// The keys fetched by each request. The account-level `tz` sets the
+// timezone for all of the account's clocks; a `tz` in a device's
+// prefs overrides it
+static          ConfigItem      items[] = {
+    { "prefs", MV_CONFIGKEYFETCHSCOPE_DEVICE,  prefsValue, sizeof(prefsValue) - 1, 0, false },
+    { "tz",    MV_CONFIGKEYFETCHSCOPE_ACCOUNT, tzValue,    sizeof(tzValue) - 1,    0, false }
+};
+constexpr       uint32_t        ITEM_COUNT = sizeof(items) / sizeof(items[0]);
+constexpr       uint32_t        PREFS_ITEM = 0;
+constexpr       uint32_t        TZ_ITEM = 1;
+
+// Hashes of the values received, and of those last applied,
+// so unchanged config can be skipped without parsing
+static          uint32_t        receivedHash = 0;
+static          uint32_t        appliedHash = 0;
+static          bool            hasApplied = false;
+
+// Prefs parsing. The documents are sized for the prefs' keys only:
+// the filter drops any others, and strings are left in `value`
+// rather than copied, so parsing never needs the heap
+constexpr       size_t          PREFS_KEY_COUNT = 7;
+static StaticJsonDocument<JSON_OBJECT_SIZE(PREFS_KEY_COUNT)> prefsFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(PREFS_KEY_COUNT)> prefsDocument;
 
 
-// Central store for notification records.
-// Holds SHARED_NC_BUFFER_SIZE_R records at a time -- each record is 16 bytes in size.
-static const    int             sharedNCBufferSizeR = 16;
-static          MvNotification  notificationCenter[sharedNCBufferSizeR] __attribute__((aligned(8)));
-static volatile uint32_t        notificationIndex = 0;
-static          Handles         handles = { nullptr, nullptr, nullptr };
-       volatile bool            receivedConfig = false;
 
+namespace Config {
 
+/**
+ * @brief Move the config fetch to a new stage.
+ *
+ * @param state: The new stage.
+ */
+static void setState(FETCH_STATE state) {
 
-namespace Config {
+    fetchState = state;
+    stateTick = HAL_GetTick();
+}
 
-bool getPrefs(Prefs& prefs) {
 
-    constexpr uint32_t CONFIG_WAIT_PERIOD_MS = 4000;
+/**
+ * @brief Abandon the current config fetch and schedule a retry,
+ *        backing off exponentially on repeated failures.
+ *
+ * @param message: Description of the failure to log.
+ *
+ * @returns `true`, as the fetch can move on at once.
+ */
+static bool fail(const char* message) {
 
-    // Check for a valid channel handle
-    if (!Channel::open()) return false;
-
-    // Set up the request parameters
-    MvConfigKeyToFetch keyOne;
-    keyOne.scope = MV_CONFIGKEYFETCHSCOPE_DEVICE;     // A device-level value
-    keyOne.store = MV_CONFIGKEYFETCHSTORE_CONFIG;     // A config-type value
-    keyOne.key = {
-        .data = (const uint8_t*)"prefs",
-        .length = 5
-    };
-
-    const uint32_t itemCount = 1;
-    MvConfigKeyToFetch keys[itemCount];
-    keys[0] = keyOne;
-
-    MvConfigKeyFetchParams request;
-    request.num_items = itemCount;
-    request.keys_to_fetch = keys;
-
-    enum MvStatus status = mvSendConfigFetchRequest(handles.channel, &request);
-    if (status != MV_STATUS_OKAY) {
-        server_error("Could not issue config fetch request");
-        Channel::close();
-        return false;
-    }
+    constexpr uint32_t MIN_BACKOFF_MS = 15 * 1000;
+    constexpr uint32_t MAX_BACKOFF_MS = 15 * 60 * 1000;
 
-    // Wait for the data to arrive
-    server_log("Awaiting params...");
-    receivedConfig = false;
-    const uint32_t startTick = HAL_GetTick();
+    LOG_ERROR(CONFIG, "%s", message);
+    fetchStats.failures++;
+    fetchFailed = true;
+    backoffMs = backoffMs == 0 ? MIN_BACKOFF_MS : backoffMs * 2;
+    if (backoffMs > MAX_BACKOFF_MS) backoffMs = MAX_BACKOFF_MS;
+    setState(FETCH_STATE::CLOSE);
+    return true;
+}
 
-    while (true) {
-        // Break out after timeout or successful config retrieval
-        if (receivedConfig || (HAL_GetTick() - startTick > CONFIG_WAIT_PERIOD_MS)) break;
-        __asm("nop");
-    }
 
-    if (!receivedConfig) {
-        // Request timed out
-        server_error("Config fetch request timed out");
-        Channel::close();
-        return false;
+/**
+ * @brief Complete the current config fetch.
+ *
+ * @returns `true`, as the fetch can move on at once.
+ */
+static bool succeed(void) {
+
+    Boot::mark(BOOT_PHASE::CONFIG_FETCHED);
+    fetchStats.fetches++;
+    fetchFailed = false;
+    backoffMs = 0;
+    setState(FETCH_STATE::CLOSE);
+    return true;
+}
+
+
+/**
+ * @brief Hash the received config values with 32-bit FNV-1a.
+ *
+ * @returns The hash.
+ */
+static uint32_t hashItems(void) {
+
+    constexpr uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+    constexpr uint32_t FNV_PRIME = 16777619UL;
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (uint32_t i = 0 ; i < ITEM_COUNT ; ++i) {
+        // Include the key's presence, so a missing value
+        // doesn't hash the same as an empty one
+        hash = (hash ^ (items[i].found ? 1 : 0)) * FNV_PRIME;
+        for (uint32_t j = 0 ; j < items[i].length ; ++j) {
+            hash = (hash ^ items[i].data[j]) * FNV_PRIME;
+        }
     }
 
-    // Parse the received data record
-    server_log("Received params");
-    MvConfigResponseData response;
-    response.result = MV_CONFIGFETCHRESULT_OK;
-    response.num_items = 0;
+    return hash;
+}
 
-    status = mvReadConfigFetchResponseData(handles.channel, &response);
-    if (status != MV_STATUS_OKAY || response.result != MV_CONFIGFETCHRESULT_OK || response.num_items != itemCount) {
-        if (response.result != MV_CONFIGFETCHRESULT_OK || response.num_items != itemCount) {
-            server_error("Please set your config as detailed in the Read Me file");
-        } else {
-            server_error("Could not get config item (status: %i; result: %i)", status, response.result);
+
+/**
+ * @brief Compare two sets of prefs.
+ *
+ * @param current: The prefs in use.
+ * @param next:    The new prefs.
+ *
+ * @returns A bitfield of PREFS_CHANGE values, one per setting that differs.
+ */
+static uint32_t diffPrefs(const Prefs& current, const Prefs& next) {
+
+    uint32_t changes = (uint32_t)PREFS_CHANGE::NONE;
+    if (current.mode != next.mode) changes |= (uint32_t)PREFS_CHANGE::MODE;
+    if (current.bst != next.bst) changes |= (uint32_t)PREFS_CHANGE::BST;
+    if (current.colon != next.colon) changes |= (uint32_t)PREFS_CHANGE::COLON;
+    if (current.flash != next.flash) changes |= (uint32_t)PREFS_CHANGE::COLON_FLASH;
+    if (current.led != next.led) changes |= (uint32_t)PREFS_CHANGE::LED;
+    if (current.brightness != next.brightness) changes |= (uint32_t)PREFS_CHANGE::BRIGHTNESS;
+    if (strncmp(current.tz, next.tz, sizeof(current.tz)) != 0) changes |= (uint32_t)PREFS_CHANGE::TZ;
+    return changes;
+}
+
+
+/**
+ * @brief Perform a single stage of the config fetch.
+ *
+ * @param prefs:   Reference to the app's preferences data.
+ * @param changes: Flags the PREFS_CHANGE settings updated in `prefs`.
+ *
+ * @returns `true` if the next stage can be performed at once,
+ *          `false` if the fetch is waiting on an event.
+ */
+static bool step(Prefs& prefs, uint32_t& changes) {
+
+    constexpr uint32_t CONFIG_WAIT_PERIOD_MS = 4000;
+    enum MvStatus status = MV_STATUS_OKAY;
+
+    switch (fetchState) {
+        case FETCH_STATE::OPEN_CHANNEL:
+            // Wait for the network, then check for a valid channel handle
+            if (Network::getState() != (uint32_t)NET_STATE::ONLINE) return false;
+            if (!Channel::open()) return fail("Could not open config channel");
+            setState(FETCH_STATE::REQUEST);
+            return true;
+
+        case FETCH_STATE::REQUEST: {
+            // Set up the request parameters: all of the keys,
+            // which are config-type values, in one request
+            MvConfigKeyToFetch keys[ITEM_COUNT];
+            for (uint32_t i = 0 ; i < ITEM_COUNT ; ++i) {
+                keys[i].scope = items[i].scope;
+                keys[i].store = MV_CONFIGKEYFETCHSTORE_CONFIG;
+                keys[i].key = {
+                    .data = (const uint8_t*)items[i].key,
+                    .length = (uint32_t)strlen(items[i].key)
+                };
+            }
+
+            MvConfigKeyFetchParams request;
+            request.num_items = ITEM_COUNT;
+            request.keys_to_fetch = keys;
+
+            receivedConfig = false;
+            status = mvSendConfigFetchRequest(handles.channel, &request);
+            if (status != MV_STATUS_OKAY) return fail("Could not issue config fetch request");
+
+            LOG_DEBUG(CONFIG, "Awaiting params...");
+            setState(FETCH_STATE::AWAIT);
+            return false;
         }
 
-        Channel::close();
-        return false;
-    }
+        case FETCH_STATE::AWAIT: {
+            // Wait for the data to arrive
+            const uint32_t latency = HAL_GetTick() - stateTick;
+            if (!receivedConfig) {
+                if (latency > CONFIG_WAIT_PERIOD_MS) return fail("Config fetch request timed out");
+                return false;
+            }
+
+            fetchStats.lastMs = latency;
+            if (latency < fetchStats.minMs) fetchStats.minMs = latency;
+            if (latency > fetchStats.maxMs) fetchStats.maxMs = latency;
+            setState(FETCH_STATE::READ);
+            return true;
+        }
+
+        case FETCH_STATE::READ: {
+            // Parse the received data record
+            LOG_DEBUG(CONFIG, "Received params");
+            MvConfigResponseData response;
+            response.result = MV_CONFIGFETCHRESULT_OK;
+            response.num_items = 0;
+
+            status = mvReadConfigFetchResponseData(handles.channel, &response);
+            if (status != MV_STATUS_OKAY || response.result != MV_CONFIGFETCHRESULT_OK || response.num_items != ITEM_COUNT) {
+                LOG_ERROR(CONFIG, "Could not get config (status: %i; result: %i)", status, response.result);
+                return fail("Config response unreadable");
+            }
+
+            for (uint32_t i = 0 ; i < ITEM_COUNT ; ++i) {
+                ConfigItem& config = items[i];
+                enum MvConfigKeyFetchResult result = MV_CONFIGKEYFETCHRESULT_OK;
+                config.length = 0;
+                memset(config.data, 0, config.size + 1);
+
+                MvConfigResponseReadItemParams item;
+                item.item_index = i;
+                item.result = &result;
+                item.buf = {
+                    .data = config.data,
+                    .size = config.size,
+                    .length = &config.length
+                };
+
+                // Get the value itself. Only the prefs are required
+                status = mvReadConfigResponseItem(handles.channel, &item);
+                config.found = (status == MV_STATUS_OKAY && result == MV_CONFIGKEYFETCHRESULT_OK);
+                if (!config.found) {
+                    config.length = 0;
+                    if (i != PREFS_ITEM) continue;
+                    if (status == MV_STATUS_OKAY && result == MV_CONFIGKEYFETCHRESULT_KEYNOTFOUND) {
+                        return fail("Please set your config as detailed in the Read Me file");
+                    }
+
+                    LOG_ERROR(CONFIG, "Could not get config item %s (status: %i; result: %i)", config.key, status, result);
+                    return fail("Config item unreadable");
+                }
+
+                LOG_DEBUG(CONFIG, "Received %s: %s", config.key, config.data);
+            }
+
+            // Parse and apply only config that has changed
+            receivedHash = hashItems();
+            if (hasApplied && receivedHash == appliedHash) {
+                LOG_DEBUG(CONFIG, "Config unchanged");
+                fetchStats.unchanged++;
+                return succeed();
+            }
+
+            setState(FETCH_STATE::PARSE);
+            return true;
+        }
+
+        case FETCH_STATE::PARSE: {
+            // Apply the settings input to a copy of the prefs,
+            // then flag the settings which differ
+            Prefs received = prefs;
+            if (!parsePrefs((char*)prefsValue, items[PREFS_ITEM].length, received)) return fail("Config JSON invalid");
+
+            // Fall back to the account's timezone
+            if (received.tz[0] == 0 && items[TZ_ITEM].found) {
+                memcpy(received.tz, tzValue, items[TZ_ITEM].length);
+                received.tz[items[TZ_ITEM].length] = 0;
+            }
+
+            changes |= diffPrefs(prefs, received);
+            prefs = received;
+            appliedHash = receivedHash;
+            hasApplied = true;
+            return succeed();
+        }
+
+        case FETCH_STATE::CLOSE:
+            Channel::close();
+            setState(fetchFailed ? FETCH_STATE::BACKOFF : FETCH_STATE::IDLE);
+            return true;
+
+        case FETCH_STATE::BACKOFF:
+            if (HAL_GetTick() - stateTick < backoffMs) return false;
+            setState(FETCH_STATE::OPEN_CHANNEL);
+            return true;
 
-    // Map the extent of `value` to the bytesize of your JSON
-    uint8_t value[257] = {0};
-    uint32_t valueLength = 0;
-    enum MvConfigKeyFetchResult result = MV_CONFIGKEYFETCHRESULT_OK;
-
-    MvConfigResponseReadItemParams item;
-    item.item_index = 0;
-    item.result = &result;
-    item.buf = {
-        .data = &value[0],
-        .size = 256,
-        .length = &valueLength
-    };
-
-    // Get the value itself
-    status = mvReadConfigResponseItem(handles.channel, &item);
-    if (status != MV_STATUS_OKAY || result != MV_CONFIGKEYFETCHRESULT_OK) {
-        server_error("Could not get config item (status: %i; result: %i)", status, result);
-        Channel::close();
-        return false;
+        default:
+            return false;
     }
+}
 
-    server_log("Received: %s", value);
-
-    // Apple the settings input to the prefs structure
-    // If a key is absent from the JSON, the cast value
-    // defaults to zero/false.
-    DynamicJsonDocument settings(256);
-    DeserializationError err = deserializeJson(settings, value);
-    if (err == DeserializationError::Ok) {
-        prefs.mode          = (bool)settings["mode"];
-        prefs.bst           = (bool)settings["bst"];
-        prefs.colon         = (bool)settings["colon"];
-        prefs.flash         = (bool)settings["flash"];
-        prefs.brightness    = (uint32_t)settings["brightness"];
-        prefs.led           = (bool)settings["led"];
+
+/**
+ * @brief Apply JSON-encoded settings to the prefs structure.
+ *
+ * If a key is absent from the JSON, its setting defaults to
+ * zero/`false`. Unknown keys are ignored. Parsing is done in
+ * place, so `json` is modified, and it uses no heap.
+ *
+ * @param json:   The JSON. Need not be NUL-terminated.
+ * @param length: The length of the JSON in bytes.
+ * @param prefs:  Reference to the app's preferences data.
+ *
+ * @returns `true` if `prefs` was updated, or `false` if
+ *          the JSON is invalid.
+ */
+bool parsePrefs(char* json, size_t length, Prefs& prefs) {
+
+    // Build the filter on first use
+    if (prefsFilter.isNull()) {
+        prefsFilter["mode"] = true;
+        prefsFilter["bst"] = true;
+        prefsFilter["colon"] = true;
+        prefsFilter["flash"] = true;
+        prefsFilter["brightness"] = true;
+        prefsFilter["led"] = true;
+        prefsFilter["tz"] = true;
     }
 
-    Channel::close();
+    // A writable input selects ArduinoJson's zero-copy mode
+    DeserializationError err = deserializeJson(prefsDocument, json, length,
+                                               DeserializationOption::Filter(prefsFilter));
+    if (err != DeserializationError::Ok) return false;
+
+    prefs.mode          = (bool)prefsDocument["mode"];
+    prefs.bst           = (bool)prefsDocument["bst"];
+    prefs.colon         = (bool)prefsDocument["colon"];
+    prefs.flash         = (bool)prefsDocument["flash"];
+    prefs.brightness    = (uint32_t)prefsDocument["brightness"];
+    prefs.led           = (bool)prefsDocument["led"];
+
+    // Timezone is optional: an absent key selects UK time
+    const char* tz = prefsDocument["tz"];
+    strncpy(prefs.tz, tz != nullptr ? tz : "", sizeof(prefs.tz) - 1);
+    prefs.tz[sizeof(prefs.tz) - 1] = 0;
     return true;
 }
 
 
+/**
+ * @brief Handle a notification tagged for the config channel.
+ *
+ * @param notification: The notification record.
+ */
+void onNotification(const MvNotification& notification) {
+
+    // Flag we need to access received data and to close the channel
+    if (notification.event_type == MV_EVENTTYPE_CHANNELDATAREADABLE) receivedConfig = true;
+}
+
+
+/**
+ * @brief Start fetching the clock settings, unless a fetch
+ *        is already under way or waiting to retry.
+ */
+void requestPrefs(void) {
+
+    if (fetchState == FETCH_STATE::IDLE) setState(FETCH_STATE::OPEN_CHANNEL);
+}
+
+
+/**
+ * @brief Advance any config fetch as far as it can go without waiting.
+ *
+ * Call this regularly from the main loop. It never blocks: each
+ * stage is a single system call, and stages that must wait for
+ * the network, the server or a retry period return at once.
+ *
+ * @param prefs: Reference to the app's preferences data.
+ *
+ * @returns A bitfield of PREFS_CHANGE values, one per setting
+ *          updated in `prefs`, or zero if none were.
+ */
+uint32_t service(Prefs& prefs) {
+
+    PROFILE_SCOPE(PROFILE_ZONE_CONFIG);
+
+    uint32_t changes = (uint32_t)PREFS_CHANGE::NONE;
+    while (step(prefs, changes)) {}
+    return changes;
+}
+
+
+/**
+ * @brief Get the config fetch counters and latencies.
+ *
+ * @returns The fetch statistics.
+ */
+FetchStats getFetchStats(void) {
+
+    return fetchStats;
+}
+
+
 namespace Channel {
 
 /**
@@ -156,8 +434,8 @@ bool open(void) {
     static uint8_t configTxBuffer[configTxBufferSizeB] __attribute__((aligned(512)));
 
     if (handles.channel == nullptr) {
-        // No network connection yet? Then establish one
-        Network::open();
+        // No network connection yet? Then we can't proceed.
+        // `Network::service()` will bring it up in the background
         if (handles.network == nullptr) return false;
 
         // Get the network channel handle.
@@ -167,7 +445,7 @@ bool open(void) {
         MvOpenChannelParams channelConfig;
         channelConfig.version = 1;
         channelConfig.v1 = {
-            .notification_handle = handles.notification,
+            .notification_handle = Notifications::getHandle(),
             .notification_tag    = (uint32_t)USER_TAG::CONFIG_OPEN_CHANNEL,
             .network_handle      = handles.network,
             .receive_buffer      = (uint8_t*)configRxBuffer,
@@ -185,12 +463,12 @@ bool open(void) {
         // and confirm that it has accepted the request
         enum MvStatus status = mvOpenChannel(&channelConfig, &handles.channel);
         if (status != MV_STATUS_OKAY) {
-            server_error("Could not open config channel. Status: %lu", status);
+            LOG_ERROR(CONFIG, "Could not open config channel. Status: %lu", status);
             return false;
         }
     }
 
-    server_log("Config Channel handle: %lu", handles.channel);
+    LOG_DEBUG(CONFIG, "Config Channel handle: %lu", handles.channel);
     return true;
 }
 
@@ -207,10 +485,10 @@ void close(void) {
         const MvChannelHandle oldHandle = handles.channel;
         enum MvStatus status = mvCloseChannel(&handles.channel);
         if (status == MV_STATUS_OKAY) {
-            server_log("Config Channel closed (handle %lu)", oldHandle);
+            LOG_DEBUG(CONFIG, "Config Channel closed (handle %lu)", oldHandle);
             handles.channel = nullptr;
         } else {
-            server_error("Could not close Config Channel");
+            LOG_ERROR(CONFIG, "Could not close Config Channel");
         }
     }
 }
@@ -221,11 +499,17 @@ void close(void) {
 
 namespace Network {
 
+/**
+ * @brief Ask Microvisor to bring up the network.
+ *
+ * This does not wait for the connection: Microvisor establishes
+ * it asynchronously and `service()` tracks its progress.
+ */
 void open(void) {
 
     // Configure the network's notification center,
     // but bail if it fails
-    if (!setupNotificationCenter()) return;
+    if (!Notifications::setup()) return;
 
     // Check if we need to establish a network
     if (handles.network == nullptr) {
@@ -233,132 +517,115 @@ void open(void) {
         MvRequestNetworkParams networkConfig;
         networkConfig.version = 1;
         networkConfig.v1 = {
-            .notification_handle = handles.notification,
+            .notification_handle = Notifications::getHandle(),
             .notification_tag = (uint32_t)USER_TAG::LOGGING_REQUEST_NETWORK,
         };
 
         // Ask Microvisor to establish the network connection
         // and confirm that it has accepted the request
-        mvRequestNetwork(&networkConfig, &handles.network);
-
-        // The network connection is established by Microvisor asynchronously,
-        // so we wait for it to come up before opening the data channel -- which
-        // would fail otherwise
-        enum MvNetworkStatus netStatus;
-        while (true) {
-            // Request the status of the network connection, identified by its handle.
-            // If we're good to continue, break out of the loop...
-            if (mvGetNetworkStatus(handles.network, &netStatus) == MV_STATUS_OKAY && netStatus == MV_NETWORKSTATUS_CONNECTED) {
-                break;
-            }
-
-            // ... or wait a short period before retrying
-            for (uint32_t i = 0; i < 50000; ++i) {
-                // No op
-                __asm("nop");
-            }
+        enum MvStatus status = mvRequestNetwork(&networkConfig, &handles.network);
+        if (status != MV_STATUS_OKAY) {
+            LOG_ERROR(NET, "Could not request network. Status: %lu", status);
+            handles.network = nullptr;
+            return;
         }
-    }
 
-    server_log("Network handle: %lu", handles.network);
-}
-
-
-uint32_t getState(void) {
+        connectStartTick = HAL_GetTick();
+        networkChanged = true;
+    }
 
-    if (handles.network == nullptr) return (uint32_t)NET_STATE::OFFLINE;
-    MvNetworkStatus netStatus;
-    MvStatus status = mvGetNetworkStatus(handles.network, &netStatus);
-    if (status != MV_STATUS_OKAY) return (uint32_t)NET_STATE::UNKNOWN;
-    return netStatus;
+    LOG_DEBUG(NET, "Network handle: %lu", handles.network);
 }
 
 
 /**
- * @brief Configure the network Notification Center.
+ * @brief Track the network connection, retrying it as needed.
+ *
+ * Call this regularly from the main loop. The connection state is
+ * refreshed when Microvisor signals a change, and polled as a
+ * fallback while the connection is down. A connection that doesn't
+ * come up in time is released and requested again, with a backoff
+ * that doubles up to a limit.
  */
-bool setupNotificationCenter(void) {
+void service(void) {
 
-    if (handles.notification == nullptr) {
-        // Clear the notification store
-        memset((void *)notificationCenter, 0xff, sizeof(notificationCenter));
+    constexpr uint32_t CONNECT_TIMEOUT_MS = 60 * 1000;
+    constexpr uint32_t POLL_PERIOD_MS = 5 * 1000;
+    constexpr uint32_t MIN_BACKOFF_MS = 5 * 1000;
+    constexpr uint32_t MAX_BACKOFF_MS = 5 * 60 * 1000;
+    const uint32_t now = HAL_GetTick();
 
-        static struct MvNotificationSetup notificationConfig = {
-            .irq = TIM8_BRK_IRQn,
-            .buffer = (struct MvNotification *)notificationCenter,
-            .buffer_size = sizeof(notificationCenter)
-        };
+    if (handles.network == nullptr) {
+        // Request the network once any backoff period has passed
+        if (now - networkRetryTick >= networkBackoffMs) {
+            networkRetryTick = now;
+            open();
+        }
 
-        // Ask Microvisor to establish the notification center
-        // and confirm that it has accepted the request
-        enum MvStatus status = mvSetupNotifications(&notificationConfig, &handles.notification);
-        if (status == MV_STATUS_OKAY) {
-            // Start the notification IRQ
-            NVIC_ClearPendingIRQ(TIM8_BRK_IRQn);
-            NVIC_EnableIRQ(TIM8_BRK_IRQn);
-        } else {
-            handles.notification = nullptr;
-            return false;
+        return;
+    }
+
+    // Refresh the state on notification, or periodically while disconnected
+    const bool isOnline = (networkState == (uint32_t)NET_STATE::ONLINE);
+    if (networkChanged || (!isOnline && now - networkPollTick >= POLL_PERIOD_MS)) {
+        networkChanged = false;
+        networkPollTick = now;
+
+        MvNetworkStatus netStatus;
+        const uint32_t newState = mvGetNetworkStatus(handles.network, &netStatus) == MV_STATUS_OKAY ? (uint32_t)netStatus : (uint32_t)NET_STATE::UNKNOWN;
+        if (newState != networkState) {
+            LOG_DEBUG(NET, "Network state: %lu", newState);
+            if (newState == (uint32_t)NET_STATE::ONLINE) {
+                Boot::mark(BOOT_PHASE::NETWORK_ONLINE);
+                networkBackoffMs = 0;
+            } else if (isOnline) {
+                // Connection lost: time the reconnection from now
+                connectStartTick = now;
+            }
+
+            networkState = newState;
         }
     }
 
-    server_log("Notification Center handle: %lu", handles.notification);
-    return true;
-}
+    // Give up on a connection attempt that's taking too long
+    if (networkState != (uint32_t)NET_STATE::ONLINE && now - connectStartTick > CONNECT_TIMEOUT_MS) {
+        networkBackoffMs = networkBackoffMs == 0 ? MIN_BACKOFF_MS : networkBackoffMs * 2;
+        if (networkBackoffMs > MAX_BACKOFF_MS) networkBackoffMs = MAX_BACKOFF_MS;
+        LOG_ERROR(NET, "Network connection timed out. Retrying in %lus", networkBackoffMs / 1000);
 
+        mvReleaseNetwork(&handles.network);
+        handles.network = nullptr;
+        networkState = (uint32_t)NET_STATE::OFFLINE;
+        networkRetryTick = now;
+    }
+}
 
-}   // Namespace Network
 
+/**
+ * @brief Get the network connection state, as last
+ *        reported by Microvisor.
+ *
+ * @returns The state, as a NET_STATE value.
+ */
+uint32_t getState(void) {
 
-}   // Namespace Config
+    return networkState;
+}
 
 
 /**
- * @brief The shared channel notification interrupt handler.
+ * @brief Handle a notification tagged for the network.
  *
- * This is called by Microvisor. We need to check for key events,
- * and signal the app via flags that data is available. This center
- * handles notifications from two channels, for config fetches and
- * HTTP requests, so we use tags to determine the source channel.
+ * @param notification: The notification record.
  */
-void TIM8_BRK_IRQHandler(void) {
-
-    // Check for readable data in the HTTP channel
-    //HAL_GPIO_WritePin(LED_GPIO_BANK, LED_GPIO_PIN, GPIO_PIN_SET);
-    bool gotNotification = false;
-    volatile MvNotification& notification = notificationCenter[notificationIndex];
-    switch(notification.tag) {
-        // Config fetch channel notifications
-        case (uint32_t)USER_TAG::CONFIG_OPEN_CHANNEL:
-            if (notification.event_type == MV_EVENTTYPE_CHANNELDATAREADABLE) {
-                // Flag we need to access received data and to close the channel
-                // when we're back in the main loop. This lets us exit the ISR quickly.
-                // Do NOT make Microvisor System Calls in the ISR!
-                receivedConfig = true;
-                gotNotification = true;
-            }
+void onNotification(const MvNotification& notification) {
 
-            break;
-        case (uint32_t)USER_TAG::LOGGING_REQUEST_NETWORK:
-            if (notification.event_type == MV_EVENTTYPE_NETWORKSTATUSCHANGED) {
-                // Change in network status -- don't really need this,
-                // but it clears the notification
-                gotNotification = true;
-            }
+    // Change in network status -- refresh the state on the next `service()`
+    if (notification.event_type == MV_EVENTTYPE_NETWORKSTATUSCHANGED) networkChanged = true;
+}
 
-            break;
-        // Others
-        default:
-            break;
-    }
 
-    // We had a relevant notification
-    if (gotNotification) {
-        // Point to the next record to be written
-        notificationIndex = (notificationIndex + 1) % sharedNCBufferSizeR;
+}   // Namespace Network
 
-        // Clear the current notifications event
-        // See https://www.twilio.com/docs/iot/microvisor/microvisor-notifications#buffer-overruns
-        notification.event_type = (MvEventType)0;
-    }
-}
+
+}   // Namespace Config
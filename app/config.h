@@ -21,15 +21,58 @@ enum class USER_TAG: uint32_t {
 };
 
 
+// Stages of a config fetch
+enum class FETCH_STATE: uint32_t {
+    IDLE = 0,
+    OPEN_CHANNEL,
+    REQUEST,
+    AWAIT,
+    READ,
+    PARSE,
+    CLOSE,
+    BACKOFF
+};
+
+
+// Prefs changed by a config fetch, as flagged by `Config::service()`
+enum class PREFS_CHANGE: uint32_t {
+    NONE = 0,
+    MODE = 0x01,
+    BST = 0x02,
+    COLON = 0x04,
+    COLON_FLASH = 0x08,
+    LED = 0x10,
+    BRIGHTNESS = 0x20,
+    TZ = 0x40
+};
+
+
 /*
  * STRUCTURES
  */
 typedef struct {
-    MvNotificationHandle    notification;
     MvNetworkHandle         network;
     MvChannelHandle         channel;
 } Handles;
 
+typedef struct {
+    uint32_t    fetches;        // Successful fetches
+    uint32_t    failures;       // Failed attempts
+    uint32_t    lastMs;         // Request-to-response latency of the last fetch
+    uint32_t    minMs;
+    uint32_t    maxMs;
+    uint32_t    unchanged;      // Successful fetches that matched the applied config
+} FetchStats;
+
+typedef struct {
+    const char*             key;
+    MvConfigKeyFetchScope   scope;
+    uint8_t*                data;       // Receives the value
+    uint32_t                size;       // Capacity of `data`, less a NUL
+    uint32_t                length;     // Length of the value received
+    bool                    found;
+} ConfigItem;
+
 
 /*
  * PROTOTYPES
@@ -43,11 +86,16 @@ namespace Config {
 
     namespace Network {
         void                open(void);
-        bool                setupNotificationCenter(void);
+        void                service(void);
         uint32_t            getState(void);
+        void                onNotification(const MvNotification& notification);
     }
 
-    bool                    getPrefs(Prefs& prefs);
+    void                    requestPrefs(void);
+    uint32_t                service(Prefs& prefs);
+    bool                    parsePrefs(char* json, size_t length, Prefs& prefs);
+    void                    onNotification(const MvNotification& notification);
+    FetchStats              getFetchStats(void);
 }
 
 
@@ -0,0 +1,374 @@
+/*
+ * Microvisor Clock Demo -- HT16K33 display group
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t INIT_TIMEOUT_MS = 100;
+
+// Each panel's init is one transaction, and they are all queued at once
+static_assert(DisplayGroup::MAX_PANELS <= I2C::QUEUE_LENGTH, "Too many panels for the I2C queue");
+static_assert(HT16K33_Segment::MAX_FRAME_BYTES <= I2C::MAX_TRANSACTION_BYTES, "A frame must fit a transaction");
+
+
+/*
+ * STRUCTURES
+ */
+// Writes to several panels, gathered into one bus transaction
+typedef struct {
+    I2C::Op             ops[I2C::MAX_TRANSACTION_OPS];
+    uint8_t             bytes[I2C::MAX_TRANSACTION_BYTES];
+    HT16K33_Segment*    panels[I2C::MAX_TRANSACTION_OPS];   // Each op's panel, if it carries a frame
+    uint32_t            opCount;
+    uint32_t            byteCount;
+} Batch;
+
+// The panels whose frames are in a queued transaction, kept until it completes
+typedef struct {
+    HT16K33_Segment*    panels[I2C::MAX_TRANSACTION_OPS];
+    uint32_t            count;
+} Delivery;
+
+
+/*
+ * GLOBALS
+ */
+// No more than `QUEUE_LENGTH` transactions are queued, so a record is
+// free again by the time the ring comes back round to it, even if the
+// transaction it is filled in for can't be queued
+static Delivery deliveries[I2C::QUEUE_LENGTH + 1];
+static uint32_t nextDelivery = 0;
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static bool addWrite(Batch& batch, HT16K33_Segment& panel, const uint8_t* data, uint32_t length, bool isFrame);
+static bool submitBatch(Batch& batch);
+static void batchDone(bool success, void* context);
+
+
+/**
+ * @brief Add a write to a batch.
+ *
+ * @param batch:   The batch.
+ * @param panel:   The panel to write to.
+ * @param data:    The bytes to write.
+ * @param length:  The number of bytes.
+ * @param isFrame: `true` if the bytes are the panel's prepared frame.
+ *
+ * @returns `true` if the write was added, or `false` if the batch is full.
+ */
+static bool addWrite(Batch& batch, HT16K33_Segment& panel, const uint8_t* data, uint32_t length, bool isFrame) {
+
+    if (batch.opCount == I2C::MAX_TRANSACTION_OPS) return false;
+    if (batch.byteCount + length > I2C::MAX_TRANSACTION_BYTES) return false;
+
+    uint8_t* bytes = &batch.bytes[batch.byteCount];
+    memcpy(bytes, data, length);
+    batch.ops[batch.opCount] = { panel.getAddress(), I2C::OP::WRITE, (uint8_t)length, bytes };
+    batch.panels[batch.opCount] = isFrame ? &panel : nullptr;
+    batch.opCount++;
+    batch.byteCount += length;
+    return true;
+}
+
+
+/**
+ * @brief Queue a batch's writes as one bus transaction, then empty it.
+ *
+ * If the transaction can't be queued, the frames in it are
+ * prepared again, and retried, at the next draw. Its outcome is
+ * passed to the panels whose frames it carries.
+ *
+ * @param batch: The batch.
+ *
+ * @returns `true` if the batch was queued, or was empty, otherwise `false`.
+ */
+static bool submitBatch(Batch& batch) {
+
+    if (batch.opCount == 0) return true;
+
+    // Fill in the record first: the callback can be made within `submit()`
+    Delivery& delivery = deliveries[nextDelivery % (I2C::QUEUE_LENGTH + 1)];
+    delivery.count = 0;
+    for (uint32_t i = 0 ; i < batch.opCount ; ++i) {
+        if (batch.panels[i] != nullptr) delivery.panels[delivery.count++] = batch.panels[i];
+    }
+
+    const bool queued = delivery.count > 0 ? I2C::submit(batch.ops, batch.opCount, batchDone, &delivery)
+                                           : I2C::submit(batch.ops, batch.opCount);
+    if (queued) {
+        if (delivery.count > 0) nextDelivery++;
+        for (uint32_t i = 0 ; i < delivery.count ; ++i) delivery.panels[i]->frameQueued();
+    }
+
+    batch.opCount = 0;
+    batch.byteCount = 0;
+    return queued;
+}
+
+
+/**
+ * @brief Pass the outcome of a batch's transaction to its panels.
+ *
+ * A NACK from any panel ends the transaction, and there's no telling
+ * which it was, so on failure every panel in it is marked as failing.
+ * Each then sends its next frame on its own, and those that succeed
+ * rejoin the batch. Called from the I2C interrupt.
+ *
+ * @param success: Did the transaction complete?
+ * @param context: The batch's delivery record.
+ */
+static void batchDone(bool success, void* context) {
+
+    const Delivery& delivery = *(const Delivery*)context;
+    for (uint32_t i = 0 ; i < delivery.count ; ++i) delivery.panels[i]->frameSent(success);
+}
+
+
+/**
+ * @brief A group of HT16K33-based displays.
+ *
+ * @param firstAddress: The I2C address of the first panel. Default: 0x70.
+ * @param maxPanels:    The number of consecutive addresses to look
+ *                      for panels at, up to eight. Default: 8.
+ */
+DisplayGroup::DisplayGroup(uint8_t firstAddress, uint32_t maxPanels)
+    :panels{ HT16K33_Segment((uint8_t)(firstAddress + 0)), HT16K33_Segment((uint8_t)(firstAddress + 1)),
+             HT16K33_Segment((uint8_t)(firstAddress + 2)), HT16K33_Segment((uint8_t)(firstAddress + 3)),
+             HT16K33_Segment((uint8_t)(firstAddress + 4)), HT16K33_Segment((uint8_t)(firstAddress + 5)),
+             HT16K33_Segment((uint8_t)(firstAddress + 6)), HT16K33_Segment((uint8_t)(firstAddress + 7)) },
+     candidates(maxPanels)
+{
+    if (candidates == 0 || candidates > MAX_PANELS) candidates = MAX_PANELS;
+}
+
+
+/**
+ * @brief Find the panels on the bus, then power them on
+ *        and set basic parameters.
+ *
+ * Panels must sit at consecutive addresses: the search stops at
+ * the first address that doesn't answer. If none do, the first
+ * panel is driven anyway, and the clock runs without it.
+ *
+ * @param brightness: A value from 0 to 15. Default: 15.
+ */
+void DisplayGroup::init(uint32_t brightness) {
+
+    count = 0;
+    while (count < candidates && I2C::probe(panels[count].getAddress())) ++count;
+    if (count == 0) {
+        LOG_ERROR(DISPLAY, "No display found at 0x%02x", panels[0].getAddress());
+        count = 1;
+    } else {
+        LOG_DEBUG(DISPLAY, "Display panels: %lu", count);
+    }
+
+    for (uint32_t i = 0 ; i < count ; ++i) panels[i].init(brightness);
+
+    // With several panels queued, let them come up, so
+    // the first frame finds room in the queue
+    if (count > 1) I2C::flush(INIT_TIMEOUT_MS);
+}
+
+
+/**
+ * @brief Get the number of panels in use.
+ *
+ * @returns The panel count.
+ */
+uint32_t DisplayGroup::size(void) const {
+
+    return count;
+}
+
+
+/**
+ * @brief Get a panel, to render to.
+ *
+ * @param index: The panel's index, from 0 to `size() - 1`.
+ *
+ * @returns The panel. Out-of-range indices get the last panel.
+ */
+HT16K33_Segment& DisplayGroup::panel(uint32_t index) {
+
+    if (index >= count) index = count > 0 ? count - 1 : 0;
+    return panels[index];
+}
+
+
+/**
+ * @brief Set the brightness of every panel, in one transaction.
+ *
+ * @param brightness: A value from 0 to 15. Default: 15.
+ */
+void DisplayGroup::setBrightness(uint32_t brightness) {
+
+    if (brightness > 15) brightness = 15;
+    sendCommand((uint8_t)HT16K33_Segment::CMD::GENERIC_BRIGHTNESS | (uint8_t)brightness);
+}
+
+
+/**
+ * @brief Set the brightness of one panel.
+ *
+ * @param index:      The panel's index.
+ * @param brightness: A value from 0 to 15.
+ */
+void DisplayGroup::setBrightness(uint32_t index, uint32_t brightness) {
+
+    if (index < count) panels[index].setBrightness(brightness);
+}
+
+
+/**
+ * @brief Power every panel on or off.
+ *
+ * @param doTurnOn: `true` to turn the panels on, `false` to turn them off.
+ *                  Default: `true`.
+ */
+void DisplayGroup::power(bool doTurnOn) {
+
+    // As `HT16K33_Segment::power()`: the oscillator runs whenever the display does
+    sendCommand(doTurnOn ? (uint8_t)HT16K33_Segment::CMD::GENERIC_SYSTEM_ON : (uint8_t)HT16K33_Segment::CMD::GENERIC_DISPLAY_OFF);
+    sendCommand(doTurnOn ? (uint8_t)HT16K33_Segment::CMD::GENERIC_DISPLAY_ON : (uint8_t)HT16K33_Segment::CMD::GENERIC_SYSTEM_OFF);
+}
+
+
+/**
+ * @brief Power one panel on or off.
+ *
+ * @param index:    The panel's index.
+ * @param doTurnOn: `true` to turn the panel on, `false` to turn it off.
+ */
+void DisplayGroup::power(uint32_t index, bool doTurnOn) {
+
+    if (index < count) panels[index].power(doTurnOn);
+}
+
+
+/**
+ * @brief Write every panel's changes out to I2C.
+ *
+ * Each panel sends only the span of its display RAM that has
+ * changed, as `HT16K33_Segment::draw()` does, but the spans are
+ * gathered into shared transactions: one for all eight panels in
+ * a typical frame. Unchanged panels cost no bus time at all.
+ *
+ * A panel whose last frame failed sends on its own, so a panel
+ * that has gone missing can't stop the others being updated.
+ */
+void DisplayGroup::draw(void) {
+
+    PROFILE_SCOPE(PROFILE_ZONE_DRAW);
+
+    Batch batch;
+    batch.opCount = 0;
+    batch.byteCount = 0;
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        HT16K33_Segment& target = panels[i];
+        uint8_t frame[HT16K33_Segment::MAX_FRAME_BYTES];
+        const uint32_t length = target.prepareFrame(frame);
+        if (length == 0) continue;
+
+        if (target.isFailing()) {
+            Batch single;
+            single.opCount = 0;
+            single.byteCount = 0;
+            addWrite(single, target, frame, length, true);
+            if (!submitBatch(single)) return;
+            transactions++;
+            continue;
+        }
+
+        // Start a new transaction when this one is full. If the
+        // queue is full too, leave the rest for the next draw
+        if (!addWrite(batch, target, frame, length, true)) {
+            if (!submitBatch(batch)) return;
+            transactions++;
+            addWrite(batch, target, frame, length, true);
+        }
+    }
+
+    if (batch.opCount > 0 && submitBatch(batch)) transactions++;
+}
+
+
+/**
+ * @brief Send the same single-byte command to every panel,
+ *        in as few transactions as possible.
+ *
+ * @param command: The command byte.
+ */
+void DisplayGroup::sendCommand(uint8_t command) {
+
+    Batch batch;
+    batch.opCount = 0;
+    batch.byteCount = 0;
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        // As in `draw()`, a failing panel gets a transaction of its own
+        if (panels[i].isFailing()) {
+            const I2C::Op op = { panels[i].getAddress(), I2C::OP::WRITE, 1, &command };
+            I2C::submit(&op, 1);
+            continue;
+        }
+
+        if (!addWrite(batch, panels[i], &command, 1, false)) {
+            submitBatch(batch);
+            addWrite(batch, panels[i], &command, 1, false);
+        }
+    }
+
+    submitBatch(batch);
+}
+
+
+/**
+ * @brief Get the number of panel frames not written because
+ *        they matched the panels' current contents.
+ *
+ * @returns The count of skipped frames, across all panels.
+ */
+uint32_t DisplayGroup::getFramesSkipped(void) const {
+
+    uint32_t total = 0;
+    for (uint32_t i = 0 ; i < count ; ++i) total += panels[i].getFramesSkipped();
+    return total;
+}
+
+
+/**
+ * @brief Get the number of display RAM bytes, including the
+ *        address pointer commands, written out to I2C.
+ *
+ * @returns The count of bytes sent, across all panels.
+ */
+uint32_t DisplayGroup::getBytesSent(void) const {
+
+    uint32_t total = 0;
+    for (uint32_t i = 0 ; i < count ; ++i) total += panels[i].getBytesSent();
+    return total;
+}
+
+
+/**
+ * @brief Get the number of bus transactions used to send frames.
+ *
+ * @returns The count of transactions.
+ */
+uint32_t DisplayGroup::getTransactions(void) const {
+
+    return transactions;
+}
@@ -0,0 +1,51 @@
+/*
+ * Microvisor Clock Demo -- HT16K33 display group
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _DISPLAY_GROUP_HEADER_
+#define _DISPLAY_GROUP_HEADER_
+
+
+/**
+    Up to eight HT16K33 panels sharing one I2C bus, at consecutive
+    addresses. Each panel keeps its own frame buffer; the group sends
+    the changes to every panel in as few bus transactions as possible.
+ */
+class DisplayGroup {
+
+    public:
+        // Constants
+        static constexpr uint32_t MAX_PANELS = 8;
+
+        // Constructor
+        explicit            DisplayGroup(uint8_t firstAddress = (uint8_t)HT16K33_Segment::DATA::ADDRESS,
+                                         uint32_t maxPanels = MAX_PANELS);
+        // Methods
+        void                init(uint32_t brightness = 15);
+        uint32_t            size(void) const;
+        HT16K33_Segment&    panel(uint32_t index);
+        void                setBrightness(uint32_t brightness = 15);
+        void                setBrightness(uint32_t index, uint32_t brightness);
+        void                power(bool doTurnOn = true);
+        void                power(uint32_t index, bool doTurnOn);
+        void                draw(void);
+        uint32_t            getFramesSkipped(void) const;
+        uint32_t            getBytesSent(void) const;
+        uint32_t            getTransactions(void) const;
+
+    private:
+        // Methods
+        void                sendCommand(uint8_t command);
+        // Properties
+        HT16K33_Segment     panels[MAX_PANELS];
+        uint32_t            candidates;         // Addresses to probe at init
+        uint32_t            count = 0;          // Panels found
+        uint32_t            transactions = 0;   // Frame transactions queued
+};
+
+
+#endif  // _DISPLAY_GROUP_HEADER_
@@ -0,0 +1,428 @@
+/*
+ * Microvisor Clock Demo -- DST namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+namespace DST {
+
+/**
+ * @brief Calculate the UTC instant at which a rule takes effect in a given year.
+ *
+ * @param rule:   The transition rule.
+ * @param year:   Full year, eg. 2024.
+ * @param offset: The UTC offset in force immediately before the transition.
+ *
+ * @returns The transition time in epoch seconds.
+ */
+static constexpr int64_t ruleInstant(const Rule& rule, int32_t year, int32_t offset) {
+
+    int32_t day = days_from_civil(year, 1, 1);
+
+    if (rule.format == DATE::JULIAN) {
+        day += (int32_t)rule.day;
+    } else if (rule.format == DATE::JULIAN_NO_LEAP) {
+        const bool isLeap = (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+        day += (int32_t)rule.day - 1 + (isLeap && rule.day >= 60 ? 1 : 0);
+    } else {
+        // Find the first matching weekday in the month, then step forward by weeks
+        const int32_t firstDay = days_from_civil(year, rule.month, 1);
+        day = firstDay + (int32_t)((7 + rule.weekday - weekday_from_days(firstDay)) % 7) + (int32_t)(rule.week - 1) * 7;
+
+        if (rule.week == 5) {
+            // Week 5 means the last such weekday, which may be in week 4
+            const int32_t nextMonthDay = rule.month == 12 ? days_from_civil(year + 1, 1, 1) : days_from_civil(year, rule.month + 1, 1);
+            while (day >= nextMonthDay) day -= 7;
+        }
+    }
+
+    return (int64_t)day * CIVIL_SECONDS_PER_DAY + rule.time - offset;
+}
+
+
+/**
+ * @brief Calculate a year's transitions for the supplied rule set.
+ *
+ * @param rules: The rule set.
+ * @param year:  Full year, eg. 2024.
+ *
+ * @returns The start and end instants.
+ */
+static constexpr Transitions calcTransitions(const RuleSet& rules, int32_t year) {
+
+    return { ruleInstant(rules.start, year, rules.stdOffset), ruleInstant(rules.end, year, rules.dstOffset) };
+}
+
+
+/*
+ * PRESETS
+ */
+// Start last Sunday of March 01:00 GMT; end last Sunday of October 02:00 BST
+constexpr RuleSet UK_RULES = { 0, 3600, { DATE::MONTH_WEEK_DAY, 3, 5, 0, 0, 3600 }, { DATE::MONTH_WEEK_DAY, 10, 5, 0, 0, 7200 }, true };
+// Start last Sunday of March 02:00 CET; end last Sunday of October 03:00 CEST
+constexpr RuleSet EU_RULES = { 3600, 7200, { DATE::MONTH_WEEK_DAY, 3, 5, 0, 0, 7200 }, { DATE::MONTH_WEEK_DAY, 10, 5, 0, 0, 10800 }, true };
+// Start second Sunday of March 02:00 EST; end first Sunday of November 02:00 EDT
+constexpr RuleSet US_RULES = { -18000, -14400, { DATE::MONTH_WEEK_DAY, 3, 2, 0, 0, 7200 }, { DATE::MONTH_WEEK_DAY, 11, 1, 0, 0, 7200 }, true };
+
+// Flash-resident tables of each preset's transitions, generated at compile time
+typedef struct {
+    Transitions years[TABLE_YEAR_COUNT];
+} Table;
+
+static constexpr Table makeTable(const RuleSet& rules) {
+
+    Table table = {};
+    for (int32_t i = 0 ; i < TABLE_YEAR_COUNT ; ++i) {
+        table.years[i] = calcTransitions(rules, FIRST_TABLE_YEAR + i);
+    }
+
+    return table;
+}
+
+static constexpr Table UK_TABLE = makeTable(UK_RULES);
+static constexpr Table EU_TABLE = makeTable(EU_RULES);
+static constexpr Table US_TABLE = makeTable(US_RULES);
+
+// 2024-03-31 01:00 UTC and 2024-10-27 01:00 UTC
+static_assert(UK_TABLE.years[24].start == 1711846800 && UK_TABLE.years[24].end == 1729990800, "Bad UK DST table");
+static_assert(EU_TABLE.years[24].start == UK_TABLE.years[24].start, "Bad EU DST table");
+// 2024-03-10 07:00 UTC and 2024-11-03 06:00 UTC
+static_assert(US_TABLE.years[24].start == 1710054000 && US_TABLE.years[24].end == 1730613600, "Bad US DST table");
+
+
+/**
+ * @brief Compare two transition rules.
+ *
+ * @returns `true` if the rules are the same, otherwise `false`.
+ */
+static bool sameRule(const Rule& a, const Rule& b) {
+
+    return a.format == b.format && a.month == b.month && a.week == b.week
+        && a.weekday == b.weekday && a.day == b.day && a.time == b.time;
+}
+
+
+/**
+ * @brief Compare two rule sets.
+ *
+ * @returns `true` if the rule sets are the same, otherwise `false`.
+ */
+static bool sameRules(const RuleSet& a, const RuleSet& b) {
+
+    return a.hasDST == b.hasDST && a.stdOffset == b.stdOffset && a.dstOffset == b.dstOffset
+        && sameRule(a.start, b.start) && sameRule(a.end, b.end);
+}
+
+
+/**
+ * @brief Calculate a year's transitions for the supplied rule set.
+ *
+ * @param rules: The rule set.
+ * @param year:  Full year, eg. 2024.
+ *
+ * @returns The start and end instants.
+ */
+Transitions transitions(const RuleSet& rules, int32_t year) {
+
+    return calcTransitions(rules, year);
+}
+
+
+/**
+ * @brief Skip a POSIX TZ zone name: either three or more letters,
+ *        or any characters enclosed in angle brackets, eg. '<+0330>'.
+ *
+ * @param tz: Pointer to the string pointer, which is advanced.
+ *
+ * @returns `true` if a valid name was skipped, otherwise `false`.
+ */
+static bool skipName(const char** tz) {
+
+    const char* p = *tz;
+    if (*p == '<') {
+        while (*p != 0 && *p != '>') ++p;
+        if (*p != '>' || p - *tz < 4) return false;
+        *tz = p + 1;
+        return true;
+    }
+
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) ++p;
+    if (p - *tz < 3) return false;
+    *tz = p;
+    return true;
+}
+
+
+/**
+ * @brief Read an unsigned decimal number.
+ *
+ * @param tz:    Pointer to the string pointer, which is advanced.
+ * @param value: Set to the number read.
+ *
+ * @returns `true` if at least one digit was read, otherwise `false`.
+ */
+static bool readNumber(const char** tz, int32_t& value) {
+
+    const char* p = *tz;
+    value = 0;
+    while (*p >= '0' && *p <= '9' && value < 100000) value = value * 10 + (*p++ - '0');
+    if (p == *tz) return false;
+    *tz = p;
+    return true;
+}
+
+
+/**
+ * @brief Read a POSIX TZ '[+|-]hh[:mm[:ss]]' time or offset.
+ *
+ * @param tz:      Pointer to the string pointer, which is advanced.
+ * @param seconds: Set to the signed time in seconds.
+ *
+ * @returns `true` if a valid time was read, otherwise `false`.
+ */
+static bool readTime(const char** tz, int32_t& seconds) {
+
+    const char* p = *tz;
+    const int32_t sign = (*p == '-') ? -1 : 1;
+    if (*p == '-' || *p == '+') ++p;
+
+    int32_t part = 0;
+    if (!readNumber(&p, part) || part > 167) return false;
+    seconds = part * 3600;
+
+    for (int32_t scale = 60 ; scale > 0 && *p == ':' ; scale /= 60) {
+        ++p;
+        if (!readNumber(&p, part) || part > 59) return false;
+        seconds += part * scale;
+    }
+
+    seconds *= sign;
+    *tz = p;
+    return true;
+}
+
+
+/**
+ * @brief Read a POSIX TZ transition rule: 'Mm.w.d', 'Jn' or 'n',
+ *        with an optional '/time' suffix.
+ *
+ * @param tz:   Pointer to the string pointer, which is advanced.
+ * @param rule: Set to the rule read.
+ *
+ * @returns `true` if a valid rule was read, otherwise `false`.
+ */
+static bool readRule(const char** tz, Rule& rule) {
+
+    const char* p = *tz;
+    int32_t a = 0, b = 0, c = 0;
+    rule = { DATE::MONTH_WEEK_DAY, 0, 0, 0, 0, 7200 };
+
+    if (*p == 'M') {
+        ++p;
+        if (!readNumber(&p, a) || *p++ != '.' || !readNumber(&p, b) || *p++ != '.' || !readNumber(&p, c)) return false;
+        if (a < 1 || a > 12 || b < 1 || b > 5 || c > 6) return false;
+        rule.month = (uint32_t)a;
+        rule.week = (uint32_t)b;
+        rule.weekday = (uint32_t)c;
+    } else if (*p == 'J') {
+        ++p;
+        if (!readNumber(&p, a) || a < 1 || a > 365) return false;
+        rule.format = DATE::JULIAN_NO_LEAP;
+        rule.day = (uint32_t)a;
+    } else {
+        if (!readNumber(&p, a) || a > 365) return false;
+        rule.format = DATE::JULIAN;
+        rule.day = (uint32_t)a;
+    }
+
+    if (*p == '/') {
+        ++p;
+        if (!readTime(&p, rule.time)) return false;
+    }
+
+    *tz = p;
+    return true;
+}
+
+
+/**
+ * @brief Parse a POSIX TZ string, eg. 'CET-1CEST,M3.5.0,M10.5.0/3'.
+ *
+ * POSIX offsets are hours *west* of UTC; they are stored as
+ * seconds east of UTC. If a DST zone is named without rules,
+ * the US rules are assumed, as glibc does.
+ *
+ * @param tz:    The TZ string.
+ * @param rules: Set to the parsed rules on success.
+ *
+ * @returns `true` if the string was valid, otherwise `false`.
+ */
+bool parseTZ(const char* tz, RuleSet& rules) {
+
+    if (tz == nullptr) return false;
+
+    RuleSet result = US_RULES;
+    int32_t offset = 0;
+    if (!skipName(&tz) || !readTime(&tz, offset)) return false;
+    result.stdOffset = -offset;
+    result.dstOffset = result.stdOffset + 3600;
+    result.hasDST = (*tz != 0);
+
+    if (result.hasDST) {
+        if (!skipName(&tz)) return false;
+        if (*tz != ',' && *tz != 0) {
+            if (!readTime(&tz, offset)) return false;
+            result.dstOffset = -offset;
+        }
+
+        if (*tz == ',') {
+            ++tz;
+            if (!readRule(&tz, result.start) || *tz++ != ',' || !readRule(&tz, result.end)) return false;
+        }
+    }
+
+    if (*tz != 0) return false;
+    rules = result;
+    return true;
+}
+
+
+/**
+ * @brief Track DST for one of the built-in rule sets.
+ *
+ * @param preset: The rule set. Default: UK.
+ */
+Zone::Zone(RULES preset)
+    :rules(UK_RULES),
+     table(UK_TABLE.years)
+{
+    if (preset == RULES::EU) {
+        rules = EU_RULES;
+        table = EU_TABLE.years;
+    } else if (preset == RULES::US) {
+        rules = US_RULES;
+        table = US_TABLE.years;
+    }
+}
+
+
+/**
+ * @brief Track DST for a custom rule set. If it matches a preset,
+ *        that preset's table is used; otherwise transitions are
+ *        calculated as they are needed.
+ *
+ * @param custom: The rule set.
+ */
+Zone::Zone(const RuleSet& custom)
+    :rules(custom),
+     table(nullptr)
+{
+    if (sameRules(custom, UK_RULES)) {
+        table = UK_TABLE.years;
+    } else if (sameRules(custom, EU_RULES)) {
+        table = EU_TABLE.years;
+    } else if (sameRules(custom, US_RULES)) {
+        table = US_TABLE.years;
+    }
+}
+
+
+/**
+ * @brief Get the UTC offset in effect at the specified time.
+ *
+ * @param utc: Time in epoch seconds.
+ *
+ * @returns The offset in seconds east of UTC.
+ */
+int32_t Zone::offset(int64_t utc) {
+
+    return isDST(utc) ? rules.dstOffset : rules.stdOffset;
+}
+
+
+/**
+ * @brief Is DST in effect at the specified time?
+ *
+ * Between transitions this is a comparison against the cached
+ * validity window; the rules are only consulted once it expires.
+ *
+ * @param utc: Time in epoch seconds.
+ *
+ * @returns `true` if DST is active, otherwise `false`.
+ */
+bool Zone::isDST(int64_t utc) {
+
+    if (!rules.hasDST) return false;
+    if (utc >= validUntil || utc < validFrom) refresh(utc);
+    return inDST;
+}
+
+
+/**
+ * @brief Get the zone's UTC offset outside of DST.
+ *
+ * @returns The offset in seconds east of UTC.
+ */
+int32_t Zone::standardOffset(void) const {
+
+    return rules.stdOffset;
+}
+
+
+/**
+ * @brief Get a year's transitions, from the flash table if we have one.
+ *
+ * @param year: Full year, eg. 2024.
+ *
+ * @returns The start and end instants.
+ */
+Transitions Zone::transitionsFor(int32_t year) const {
+
+    if (table != nullptr && year >= FIRST_TABLE_YEAR && year < FIRST_TABLE_YEAR + TABLE_YEAR_COUNT) {
+        return table[year - FIRST_TABLE_YEAR];
+    }
+
+    return calcTransitions(rules, year);
+}
+
+
+/**
+ * @brief Recalculate the DST state and the window over which it holds.
+ *
+ * @param utc: Time in epoch seconds.
+ */
+void Zone::refresh(int64_t utc) {
+
+    // Gather the transitions of the surrounding years, in time order.
+    // Each instant is paired with the DST state it brings about
+    const int32_t year = civil_time_from_epoch(utc).year;
+    int64_t instants[6] = {};
+    bool states[6] = {};
+    uint32_t count = 0;
+
+    for (int32_t y = year - 1 ; y <= year + 1 ; ++y) {
+        const Transitions t = transitionsFor(y);
+        const int64_t first = t.start < t.end ? t.start : t.end;
+        const int64_t second = t.start < t.end ? t.end : t.start;
+        instants[count] = first;
+        states[count++] = (first == t.start);
+        instants[count] = second;
+        states[count++] = (second == t.start);
+    }
+
+    // Find the last transition at or before `utc`
+    uint32_t i = 0;
+    while (i < count && instants[i] <= utc) ++i;
+
+    inDST = states[i == 0 ? count - 1 : i - 1];
+    validFrom = i == 0 ? INT64_MIN : instants[i - 1];
+    validUntil = i == count ? INT64_MAX : instants[i];
+}
+
+
+}   // namespace DST
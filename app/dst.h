@@ -0,0 +1,102 @@
+/*
+ * Microvisor Clock Demo -- DST namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _DST_HEADER_
+#define _DST_HEADER_
+
+
+namespace DST {
+
+    /*
+     * CONSTANTS
+     */
+    // Years covered by the precomputed transition tables
+    constexpr int32_t   FIRST_TABLE_YEAR = 2000;
+    constexpr int32_t   TABLE_YEAR_COUNT = 100;
+
+
+    /*
+     * ENUMERATIONS
+     */
+    enum class RULES: uint32_t {
+        UK = 0,         // GMT/BST
+        EU,             // CET/CEST
+        US,             // EST/EDT
+        CUSTOM
+    };
+
+
+    // POSIX TZ transition date formats
+    enum class DATE: uint32_t {
+        MONTH_WEEK_DAY = 0,     // 'Mm.w.d'
+        JULIAN_NO_LEAP,         // 'Jn': 1-365, February 29 is never counted
+        JULIAN                  // 'n':  0-365, February 29 is counted
+    };
+
+
+    /*
+     * STRUCTURES
+     */
+    // A POSIX-style transition rule, eg. 'M3.5.0/1'
+    typedef struct {
+        DATE        format;
+        uint32_t    month;      // 1-12
+        uint32_t    week;       // 1-5, where 5 is the last such weekday of the month
+        uint32_t    weekday;    // 0 (Sunday) to 6 (Saturday)
+        uint32_t    day;        // Day number, for the Julian formats
+        int32_t     time;       // Local time of the change, in seconds after midnight
+    } Rule;
+
+    typedef struct {
+        int32_t     stdOffset;  // Seconds east of UTC outside of DST
+        int32_t     dstOffset;  // Seconds east of UTC during DST
+        Rule        start;      // Change to DST, in standard local time
+        Rule        end;        // Change back, in daylight local time
+        bool        hasDST;     // Does the zone observe DST at all?
+    } RuleSet;
+
+    // The UTC instants (epoch seconds) of one year's transitions
+    typedef struct {
+        int64_t     start;
+        int64_t     end;
+    } Transitions;
+
+
+    /*
+     * CLASSES
+     */
+    class Zone {
+
+        public:
+            // Constructors
+            explicit            Zone(RULES preset = RULES::UK);
+            explicit            Zone(const RuleSet& custom);
+            // Methods
+            int32_t             offset(int64_t utc);
+            bool                isDST(int64_t utc);
+            int32_t             standardOffset(void) const;
+
+        private:
+            // Methods
+            void                refresh(int64_t utc);
+            Transitions         transitionsFor(int32_t year) const;
+            // Properties
+            RuleSet             rules;
+            const Transitions*  table;
+            // Cached state, valid for `validFrom <= utc < validUntil`
+            int64_t             validFrom = 0;
+            int64_t             validUntil = 0;
+            bool                inDST = false;
+    };
+
+    Transitions             transitions(const RuleSet& rules, int32_t year);
+    bool                    parseTZ(const char* tz, RuleSet& rules);
+}
+
+
+#endif  // _DST_HEADER_
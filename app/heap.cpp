@@ -0,0 +1,103 @@
+/*
+ * Microvisor Clock Demo -- Heap namespace
+ *
+ * Counts heap allocations. The app is linked with
+ * `--wrap=malloc,--wrap=calloc,--wrap=realloc`, so the linker
+ * routes those calls through the wrappers below, which count
+ * them and pass them on to the C library. Allocations the C
+ * library makes internally, eg. for stdio, aren't counted.
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * GLOBALS
+ */
+static volatile bool        booted = false;
+static          HeapStats   stats = { 0, 0, 0 };
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void count(size_t size);
+
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+
+
+/**
+ * @brief Counting replacements for the C library allocators.
+ */
+void* __wrap_malloc(size_t size) {
+
+    count(size);
+    return __real_malloc(size);
+}
+
+
+void* __wrap_calloc(size_t number, size_t size) {
+
+    count(number * size);
+    return __real_calloc(number, size);
+}
+
+
+void* __wrap_realloc(void* block, size_t size) {
+
+    count(size);
+    return __real_realloc(block, size);
+}
+
+}   // extern "C"
+
+
+/**
+ * @brief Record an allocation.
+ *
+ * @param size: The number of bytes requested.
+ */
+static void count(size_t size) {
+
+    stats.allocations++;
+    if (booted) {
+        stats.allocationsAfterBoot++;
+        stats.bytesAfterBoot += (uint32_t)size;
+    }
+}
+
+
+namespace Heap {
+
+/**
+ * @brief Mark the end of start-up. From now on the app
+ *        should not allocate: any allocation is counted
+ *        in `allocationsAfterBoot`.
+ */
+void markBooted(void) {
+
+    booted = true;
+}
+
+
+/**
+ * @brief Get the allocation counts.
+ *
+ * @returns The counts.
+ */
+HeapStats getStats(void) {
+
+    return stats;
+}
+
+
+}   // namespace Heap
@@ -0,0 +1,33 @@
+/*
+ * Microvisor Clock Demo -- Heap namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _HEAP_HEADER_
+#define _HEAP_HEADER_
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    allocations;            // All allocations since reset
+    uint32_t    allocationsAfterBoot;   // Allocations since `markBooted()` was called
+    uint32_t    bytesAfterBoot;         // Bytes requested since `markBooted()` was called
+} HeapStats;
+
+
+/*
+ * PROTOTYPES
+ */
+namespace Heap {
+
+    void        markBooted(void);
+    HeapStats   getStats(void);
+}
+
+
+#endif  // _HEAP_HEADER_
@@ -12,15 +12,43 @@
 /*
  * CONSTANTS
  */
-constexpr uint32_t SIZE_OF_TX_BUFFER_BYTES = 17;
+constexpr uint32_t SIZE_OF_TX_BUFFER_BYTES = HT16K33::MAX_FRAME_BYTES;
+
+// The layout and font tables are indexed at run time, so before C++17,
+// the default for the device's GCC 9, they need these definitions
+#if __cplusplus < 201703L
+constexpr uint8_t SevenSegmentLayout::POS[];
+constexpr uint8_t SevenSegmentFont::TABLE[];
+constexpr uint16_t FourteenSegmentFont::TABLE[];
+#endif
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void writeDone(bool success, void* context);
+
+
+/**
+ * @brief Pass the outcome of a display RAM write to its panel.
+ *
+ * Called from the I2C interrupt.
+ *
+ * @param success: Did the write complete?
+ * @param context: The panel.
+ */
+static void writeDone(bool success, void* context) {
+
+    ((HT16K33*)context)->frameSent(success);
+}
 
 
 /**
- * @brief Basic driver for HT16K33-based display.
+ * @brief The common part of a driver for an HT16K33-based panel.
  *
  * @param address: The display's I2C address. Default: 0x70.
  */
-HT16K33_Segment::HT16K33_Segment(uint8_t address)
+HT16K33::HT16K33(uint8_t address)
     :i2cAddr(address)
 {
     if (i2cAddr == 0x00 || i2cAddr > 0x7F) i2cAddr = (uint8_t)DATA::ADDRESS;
@@ -30,13 +58,33 @@ HT16K33_Segment::HT16K33_Segment(uint8_t address)
 /**
  * @brief Convenience function to power on the display
  *        and set basic parameters.
+ *
+ * The power, brightness and cleared-RAM writes are made as one
+ * bus transaction.
+ *
+ * @param brightness: A value from 0 to 15. Default: 15.
  */
-void HT16K33_Segment::init(uint32_t brightness) {
+void HT16K33::init(uint32_t brightness) {
 
-    power(true);
-    setBrightness(brightness);
-    clear();
-    draw();
+    if (brightness > 15) brightness = 15;
+    uint8_t systemOn = (uint8_t)CMD::GENERIC_SYSTEM_ON;
+    uint8_t displayOn = (uint8_t)CMD::GENERIC_DISPLAY_ON;
+    uint8_t level = (uint8_t)CMD::GENERIC_BRIGHTNESS | (uint8_t)brightness;
+    uint8_t ram[SIZE_OF_TX_BUFFER_BYTES] = {0};
+    ram[0] = (uint8_t)CMD::GENERIC_DISPLAY_ADDRESS;
+
+    const I2C::Op ops[4] = {
+        { i2cAddr, I2C::OP::WRITE, 1, &systemOn },
+        { i2cAddr, I2C::OP::WRITE, 1, &displayOn },
+        { i2cAddr, I2C::OP::WRITE, 1, &level },
+        { i2cAddr, I2C::OP::WRITE, SIZE_OF_TX_BUFFER_BYTES, ram }
+    };
+
+    // The chip's RAM now matches the cleared buffer
+    memset(buffer, 0x00, 16);
+    shadowStale = false;
+    shadowValid = I2C::submit(ops, 4, writeDone, this);
+    memset(shadow, 0x00, 16);
 }
 
 
@@ -46,10 +94,16 @@ void HT16K33_Segment::init(uint32_t brightness) {
  * @param on: `true` to turn the display on, `false` to turn it off.
               Default: `true`.
  */
-void HT16K33_Segment::power(bool on) const {
+void HT16K33::power(bool on) const {
 
-    I2C::writeByte(i2cAddr, on ? (uint8_t)CMD::GENERIC_SYSTEM_ON : (uint8_t)CMD::GENERIC_DISPLAY_OFF);
-    I2C::writeByte(i2cAddr, on ? (uint8_t)CMD::GENERIC_DISPLAY_ON : (uint8_t)CMD::GENERIC_SYSTEM_OFF);
+    uint8_t first = on ? (uint8_t)CMD::GENERIC_SYSTEM_ON : (uint8_t)CMD::GENERIC_DISPLAY_OFF;
+    uint8_t second = on ? (uint8_t)CMD::GENERIC_DISPLAY_ON : (uint8_t)CMD::GENERIC_SYSTEM_OFF;
+    const I2C::Op ops[2] = {
+        { i2cAddr, I2C::OP::WRITE, 1, &first },
+        { i2cAddr, I2C::OP::WRITE, 1, &second }
+    };
+
+    I2C::submit(ops, 2);
 }
 
 
@@ -58,7 +112,7 @@ void HT16K33_Segment::power(bool on) const {
  *
  * @param brightness: A value from 0 to 15. Default: 15.
  */
-void HT16K33_Segment::setBrightness(uint32_t brightness) const {
+void HT16K33::setBrightness(uint32_t brightness) const {
 
     if (brightness > 15) brightness = 15;
     I2C::writeByte(i2cAddr, (uint8_t)CMD::GENERIC_BRIGHTNESS | (uint8_t)brightness);
@@ -66,117 +120,158 @@ void HT16K33_Segment::setBrightness(uint32_t brightness) const {
 
 
 /**
- * @brief Clear the display buffer and then write it out.
+ * @brief Set the rate at which the whole display blinks.
  *
- * @retval The instance.
+ * @param rate: The blink rate. Default: `BLINK::OFF`.
  */
-HT16K33_Segment& HT16K33_Segment::clear() {
+void HT16K33::setBlink(BLINK rate) const {
 
-    memset(buffer, 0x00, 16);
-    return *this;
+    I2C::writeByte(i2cAddr, (uint8_t)CMD::GENERIC_BLINK | (uint8_t)((uint32_t)rate << 1));
 }
 
+
 /**
- * @brief Set or unset the display colon.
+ * @brief Write the display buffer out to I2C.
  *
- * @param isSet: `true` if the colon is to be lit, otherwise `false`.
+ * Only the span of display RAM that differs from what was last
+ * written is sent, using the HT16K33's auto-incrementing address
+ * pointer. If nothing has changed, no transfer takes place.
  *
- * @retval The instance.
+ * The write is queued and takes place in the background from
+ * a copy of the changed bytes, so the buffer may be updated for
+ * the next frame while this one is still on the bus.
  */
-HT16K33_Segment& HT16K33_Segment::setColon(bool isSet) {
+void HT16K33::draw() {
+
+    PROFILE_SCOPE(PROFILE_ZONE_DRAW);
+
+    // Queue the transmit buffer. If it can't be queued,
+    // the shadow is left as is so the bytes are retried
+    uint8_t txBuffer[SIZE_OF_TX_BUFFER_BYTES];
+    const uint32_t length = prepareFrame(txBuffer);
+    if (length == 0) return;
 
-    buffer[(int)SEGMENT::COLON_ROW] = isSet ? 0x02 : 0x00;
-    return *this;
+    const I2C::Op op = { i2cAddr, I2C::OP::WRITE, (uint8_t)length, txBuffer };
+    if (I2C::submit(&op, 1, writeDone, this)) frameQueued();
 }
 
 
 /**
- * @brief Present a user-defined character glyph at the specified digit.
+ * @brief Build the bytes that bring the display's RAM up to date
+ *        with the buffer, without sending them.
  *
- * @param glyph:  The glyph value.
- * @param digit:  The target digit: L-R, 0-4.
- * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
- *                Default: `false`.
+ * Call `frameQueued()` once the bytes have been queued for the
+ * bus; until then, the same changes are prepared again each time.
+ * Pass the transaction's outcome to `frameSent()`.
  *
- * @retval The instance.
+ * @param frame: A buffer of at least `MAX_FRAME_BYTES` bytes.
+ *
+ * @returns The number of bytes to write, or 0 if nothing has changed.
  */
-HT16K33_Segment& HT16K33_Segment::setGlyph(uint32_t glyph, uint32_t digit, bool hasDot) {
+uint32_t HT16K33::prepareFrame(uint8_t* frame) {
+
+    // A failed write to this display since the last draw leaves
+    // its RAM state unknown, so resend everything
+    if (shadowStale) {
+        shadowStale = false;
+        shadowValid = false;
+    }
 
-    if (digit > 4) return *this;
-    if (glyph > 0xFF) return *this;
-    buffer[HT16K33_Segment::POS[digit]] = (uint8_t)glyph;
-    if (hasDot) buffer[HT16K33_Segment::POS[digit]] |= 0x80;
-    return *this;
+    // Find the first and last changed bytes
+    uint32_t first = 0;
+    uint32_t last = 15;
+    if (shadowValid) {
+        while (first < 16 && buffer[first] == shadow[first]) ++first;
+        if (first == 16) {
+            // Frame unchanged -- nothing to send
+            framesSkipped++;
+            frameCount = 0;
+            return 0;
+        }
+
+        while (buffer[last] == shadow[last]) --last;
+    }
+
+    // Point the chip at the first changed RAM address,
+    // then copy in the changed bytes
+    frameFirst = first;
+    frameCount = last - first + 1;
+    frame[0] = (uint8_t)CMD::GENERIC_DISPLAY_ADDRESS | (uint8_t)first;
+    memcpy(&frame[1], &buffer[first], frameCount);
+    return frameCount + 1;
 }
 
 
 /**
- * @brief Present a decimal number at the specified digit.
+ * @brief Record that the frame last prepared has been queued,
+ *        so the display's RAM will match it.
+ */
+void HT16K33::frameQueued(void) {
+
+    if (frameCount == 0) return;
+    memcpy(&shadow[frameFirst], &buffer[frameFirst], frameCount);
+    shadowValid = true;
+    bytesSent += frameCount + 1;
+    frameCount = 0;
+}
+
+
+/**
+ * @brief Record the outcome of a queued frame, or of `init()`.
  *
- * @param number: The number (0-9).
- * @param digit:  The target digit: L-R, 0-4.
- * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
- *                efault: `false`.
+ * If it failed, the next frame resends the whole of display RAM.
+ * Called from the I2C interrupt.
  *
- * @retval The instance.
+ * @param success: Did the write complete?
  */
-HT16K33_Segment& HT16K33_Segment::setNumber(uint32_t number, uint32_t digit, bool hasDot) {
+void HT16K33::frameSent(bool success) {
 
-    if (digit > 4) return *this;
-    if (number > 9) return *this;
-    return setAlpha('0' + (char)number, digit, hasDot);
+    if (!success) shadowStale = true;
+    failing = !success;
 }
 
 
 /**
- * @brief Present an alphanumeric character glyph at the specified digit.
- *
- * @param chr:    The character.
- * @param digit:  The target digit: L-R, 0-4.
- * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
- *                Default: `false`.
- *
- * @retval The instance.
- */
-HT16K33_Segment& HT16K33_Segment::setAlpha(char chr, uint32_t digit, bool hasDot) {
-
-    if (digit > 4) return *this;
-
-    uint8_t charVal = 0xFF;
-    if (chr == ' ') {
-        charVal = (uint8_t)SEGMENT::SPACE_CHAR;
-    } else if (chr == '-') {
-        charVal = (uint8_t)SEGMENT::MINUS_CHAR;
-    } else if (chr == 'o') {
-        charVal = (uint8_t)SEGMENT::DEGREE_CHAR;
-    } else if (chr >= 'a' && chr <= 'f') {
-        charVal = (uint8_t)chr - 87;
-    } else if (chr >= '0' && chr <= '9') {
-        charVal = (uint8_t)chr - 48;
-    }
+ * @brief Did the display's last frame fail to reach it?
+ *
+ * @returns `true` if it failed, otherwise `false`.
+ */
+bool HT16K33::isFailing(void) const {
 
-    if (charVal == 0xFF) return *this;
-    buffer[POS[digit]] = CHARSET[charVal];
-    if (hasDot) buffer[POS[digit]] |= 0x80;
-    return *this;
+    return failing;
 }
 
 
 /**
- * @brief Write the display buffer out to I2C.
+ * @brief Get the display's I2C address.
+ *
+ * @returns The address.
  */
-void HT16K33_Segment::draw() const {
+uint8_t HT16K33::getAddress(void) const {
 
-    // Set up the buffer holding the data to be
-    // transmitted to the LED
-    static uint8_t txBuffer[SIZE_OF_TX_BUFFER_BYTES] = {0};
+    return i2cAddr;
+}
 
-    // Span the 8 bytes of the graphics buffer
-    // across the 16 bytes of the LED's buffer
-    for (uint32_t i = 0 ; i < 16 ; ++i) {
-        txBuffer[i + 1] = buffer[i];
-    }
 
-    // Write out the transmit buffer
-    I2C::writeBlock(i2cAddr, txBuffer, SIZE_OF_TX_BUFFER_BYTES);
+/**
+ * @brief Get the number of frames not written because
+ *        they matched the display's current contents.
+ *
+ * @returns The count of skipped frames.
+ */
+uint32_t HT16K33::getFramesSkipped(void) const {
+
+    return framesSkipped;
+}
+
+
+/**
+ * @brief Get the number of display RAM bytes, including the
+ *        address pointer command, written out to I2C.
+ *
+ * @returns The count of bytes sent.
+ */
+uint32_t HT16K33::getBytesSent(void) const {
+
+    return bytesSent;
 }
@@ -11,9 +11,10 @@
 
 
 /**
-    A basic driver for I2C-connected HT16K33-based four-digit, seven-segment displays.
+    The parts of the driver common to every HT16K33-based panel: the
+    command set, the display RAM buffer, and its transfer over I2C.
  */
-class HT16K33_Segment {
+class HT16K33 {
 
     public:
         // Constants
@@ -31,36 +32,282 @@ class HT16K33_Segment {
             ADDRESS =                   0x70
         };
 
-        enum class SEGMENT {
-            COLON_ROW =                 0x04,
-            MINUS_CHAR =                0x10,
-            DEGREE_CHAR =               0x11,
-            SPACE_CHAR =                0x00
+        enum class BLINK {
+            OFF =                       0,
+            FAST =                      1,      // 2Hz
+            MEDIUM =                    2,      // 1Hz
+            SLOW =                      3       // 0.5Hz
         };
 
+        // Display RAM bytes, plus the address pointer command, in a full frame
+        static constexpr uint32_t MAX_FRAME_BYTES = 17;
+
         // Constructor
-        explicit            HT16K33_Segment(uint8_t address = (uint8_t)DATA::ADDRESS);
+        explicit            HT16K33(uint8_t address = (uint8_t)DATA::ADDRESS);
         // Methods
         void                init(uint32_t brightness = 15);
         void                power(bool doTurnOn = true) const;
         void                setBrightness(uint32_t brightness = 15) const;
-        HT16K33_Segment&    setColon(bool isSet = false);
-        HT16K33_Segment&    setGlyph(uint32_t glyph, uint32_t digit, bool hasDot = false);
-        HT16K33_Segment&    setNumber(uint32_t number, uint32_t digit, bool hasDot = false);
-        HT16K33_Segment&    setAlpha(char chr, uint32_t digit, bool hasDot = false);
-        HT16K33_Segment&    clear(void);
-        void                draw(void) const;
+        void                setBlink(BLINK rate = BLINK::OFF) const;
+        void                draw(void);
+        uint32_t            prepareFrame(uint8_t* frame);
+        void                frameQueued(void);
+        void                frameSent(bool success);
+        bool                isFailing(void) const;
+        uint8_t             getAddress(void) const;
+        uint32_t            getFramesSkipped(void) const;
+        uint32_t            getBytesSent(void) const;
 
-    private:
-        // Methods
+    protected:
+        // Properties
         uint8_t             buffer[16];
+
+    private:
+        // Properties
+        uint8_t             shadow[16];         // Display RAM contents as last written to the chip
+        bool                shadowValid = false;
+        // Set from the I2C interrupt when a write to display RAM fails
+        volatile bool       shadowStale = false;
+        volatile bool       failing = false;
         uint8_t             i2cAddr;
-        // Constants
-        // Following are populated in the constructor
-        const uint8_t       CHARSET[18] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F,
-                                           0x6F, 0x5F, 0x7C, 0x58, 0x5E, 0x7B, 0x71, 0x40, 0x63};
-        const uint8_t       POS[4] = {0, 2, 6, 8};
+        // Span of the frame last prepared
+        uint32_t            frameFirst = 0;
+        uint32_t            frameCount = 0;
+        // Traffic counters
+        uint32_t            framesSkipped = 0;
+        uint32_t            bytesSent = 0;
 };
 
 
+/**
+    A driver for one type of HT16K33-based panel. `Layout` maps digits,
+    and any extras such as a colon or pixels, onto display RAM. `Font`
+    maps characters to glyphs. Both are resolved at compile time, and
+    their tables are shared by every instance. Methods a panel type
+    doesn't support, such as `setColon()` on a matrix, don't compile.
+ */
+template <typename Layout, typename Font = NoFont>
+class HT16K33_Display : public HT16K33 {
+
+    public:
+        using Glyph = typename Layout::Glyph;
+
+        // Constructor
+        explicit            HT16K33_Display(uint8_t address = (uint8_t)DATA::ADDRESS) : HT16K33(address) {}
+        // Methods
+        HT16K33_Display&    clear(void);
+        HT16K33_Display&    setGlyph(Glyph glyph, uint32_t digit, bool hasDot = false);
+        HT16K33_Display&    setNumber(uint32_t number, uint32_t digit, bool hasDot = false);
+        HT16K33_Display&    setAlpha(char chr, uint32_t digit, bool hasDot = false);
+        HT16K33_Display&    setText(const char* text, uint32_t digit = 0);
+        HT16K33_Display&    setColon(bool isSet = false);
+        HT16K33_Display&    setPixel(uint32_t x, uint32_t y, bool isSet = true);
+        HT16K33_Display&    setBar(uint32_t bar, BAR_COLOR color);
+        Glyph               getDigit(uint32_t digit) const;
+        static Glyph        getGlyph(char chr);
+        static Glyph        nextGlyph(const char*& text);
+};
+
+
+/*
+ * PANEL TYPES
+ */
+using HT16K33_Segment       = HT16K33_Display<SevenSegmentLayout, SevenSegmentFont>;
+using HT16K33_Alphanumeric  = HT16K33_Display<FourteenSegmentLayout, FourteenSegmentFont>;
+using HT16K33_Matrix        = HT16K33_Display<MatrixLayout>;
+using HT16K33_Bargraph      = HT16K33_Display<BargraphLayout>;
+
+
+/**
+ * @brief Clear the display buffer. It is not written out.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::clear(void) {
+
+    memset(buffer, 0x00, 16);
+    return *this;
+}
+
+
+/**
+ * @brief Present a user-defined character glyph at the specified digit.
+ *
+ * @param glyph:  The glyph value.
+ * @param digit:  The target digit, L-R, from 0.
+ * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
+ *                Default: `false`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setGlyph(Glyph glyph, uint32_t digit, bool hasDot) {
+
+    if (digit >= Layout::DIGITS) return *this;
+    Layout::setGlyph(buffer, digit, hasDot ? (Glyph)(glyph | Layout::DOT) : glyph);
+    return *this;
+}
+
+
+/**
+ * @brief Present a decimal number at the specified digit.
+ *
+ * @param number: The number (0-9).
+ * @param digit:  The target digit, L-R, from 0.
+ * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
+ *                Default: `false`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setNumber(uint32_t number, uint32_t digit, bool hasDot) {
+
+    if (number > 9) return *this;
+    return setAlpha('0' + (char)number, digit, hasDot);
+}
+
+
+/**
+ * @brief Present an alphanumeric character glyph at the specified digit.
+ *
+ * @param chr:    The character: any 7-bit ASCII character. Those
+ *                the font can't show show blank.
+ * @param digit:  The target digit, L-R, from 0.
+ * @param hasDot: `true` if the decimal point is to be lit, otherwise `false`.
+ *                Default: `false`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setAlpha(char chr, uint32_t digit, bool hasDot) {
+
+    return setGlyph(getGlyph(chr), digit, hasDot);
+}
+
+
+/**
+ * @brief Present a string, starting at the specified digit.
+ *
+ * A '.' lights the decimal point of the character before it,
+ * so "12.34" fills four digits. Digits after the end of the
+ * string are blanked; characters that don't fit are dropped.
+ *
+ * @param text:  The string.
+ * @param digit: The first digit to fill, L-R, from 0. Default: 0.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setText(const char* text, uint32_t digit) {
+
+    for ( ; digit < Layout::DIGITS ; ++digit) {
+        Layout::setGlyph(buffer, digit, nextGlyph(text));
+    }
+
+    return *this;
+}
+
+
+/**
+ * @brief Set or unset the display colon.
+ *
+ * @param isSet: `true` if the colon is to be lit, otherwise `false`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setColon(bool isSet) {
+
+    Layout::setColon(buffer, isSet);
+    return *this;
+}
+
+
+/**
+ * @brief Light or clear one pixel of a matrix.
+ *
+ * @param x:     The column, L-R, from 0.
+ * @param y:     The row, top to bottom, from 0.
+ * @param isSet: `true` to light the pixel, `false` to clear it. Default: `true`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setPixel(uint32_t x, uint32_t y, bool isSet) {
+
+    Layout::setPixel(buffer, x, y, isSet);
+    return *this;
+}
+
+
+/**
+ * @brief Set the colour of one bar of a bargraph.
+ *
+ * @param bar:   The bar, from 0.
+ * @param color: The colour, or `BAR_COLOR::OFF`.
+ *
+ * @retval The instance.
+ */
+template <typename Layout, typename Font>
+HT16K33_Display<Layout, Font>& HT16K33_Display<Layout, Font>::setBar(uint32_t bar, BAR_COLOR color) {
+
+    Layout::setBar(buffer, bar, color);
+    return *this;
+}
+
+
+/**
+ * @brief Get the glyph in the buffer at the specified digit.
+ *
+ * @param digit: The digit, L-R, from 0.
+ *
+ * @returns The glyph, including its decimal point, or 0 if there is no such digit.
+ */
+template <typename Layout, typename Font>
+typename Layout::Glyph HT16K33_Display<Layout, Font>::getDigit(uint32_t digit) const {
+
+    if (digit >= Layout::DIGITS) return 0;
+    return Layout::getGlyph(buffer, digit);
+}
+
+
+/**
+ * @brief Get the glyph for a character.
+ *
+ * @param chr: The character.
+ *
+ * @returns The glyph, or 0 (blank) if the character is not 7-bit ASCII.
+ */
+template <typename Layout, typename Font>
+typename Layout::Glyph HT16K33_Display<Layout, Font>::getGlyph(char chr) {
+
+    return ((uint8_t)chr < 128) ? Font::TABLE[(uint8_t)chr] : 0;
+}
+
+
+/**
+ * @brief Take the next character's glyph from a string, with
+ *        its decimal point lit if a '.' follows it.
+ *
+ * @param text: The string, advanced past the characters used.
+ *              At the end of the string, it is left in place.
+ *
+ * @returns The glyph, or 0 (blank) at the end of the string.
+ */
+template <typename Layout, typename Font>
+typename Layout::Glyph HT16K33_Display<Layout, Font>::nextGlyph(const char*& text) {
+
+    if (*text == 0) return 0;
+
+    Glyph glyph = getGlyph(*text++);
+    if (*text == '.') {
+        glyph |= Layout::DOT;
+        ++text;
+    }
+
+    return glyph;
+}
+
+
 #endif  // _HT16K33_HEADER_
@@ -0,0 +1,223 @@
+/*
+ * Microvisor Clock Demo -- HT16K33 panel layouts and fonts
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _HT16K33_LAYOUTS_HEADER_
+#define _HT16K33_LAYOUTS_HEADER_
+
+
+/*
+ * ENUMERATIONS
+ */
+enum class BAR_COLOR: uint8_t {
+    OFF = 0,
+    RED,
+    GREEN,
+    YELLOW
+};
+
+
+/*
+ * LAYOUTS
+ *
+ * Each maps a panel's digits, and its extras, onto the HT16K33's
+ * 16 bytes of display RAM: eight rows of 16 column bits, low byte
+ * first. Everything is static, so a panel type costs no RAM beyond
+ * its driver's buffers.
+ */
+
+/**
+    Four-digit, seven-segment display with a centre colon, as on
+    the Adafruit 0.56" and 1.2" backpacks.
+ */
+struct SevenSegmentLayout {
+
+    typedef uint8_t Glyph;
+
+    static constexpr uint32_t   DIGITS = 4;
+    static constexpr Glyph      DOT = 0x80;
+    static constexpr uint8_t    POS[DIGITS] = {0, 2, 6, 8};
+    static constexpr uint8_t    COLON_ROW = 4;
+    static constexpr uint8_t    COLON_BIT = 0x02;
+
+    static void setGlyph(uint8_t* buffer, uint32_t digit, Glyph glyph) {
+        buffer[POS[digit]] = glyph;
+    }
+
+    static Glyph getGlyph(const uint8_t* buffer, uint32_t digit) {
+        return buffer[POS[digit]];
+    }
+
+    static void setColon(uint8_t* buffer, bool isSet) {
+        buffer[COLON_ROW] = isSet ? COLON_BIT : 0x00;
+    }
+};
+
+
+/**
+    Four-character, 14-segment alphanumeric display, as on the
+    Adafruit quad alphanumeric backpack. Each character is one row.
+ */
+struct FourteenSegmentLayout {
+
+    typedef uint16_t Glyph;
+
+    static constexpr uint32_t   DIGITS = 4;
+    static constexpr Glyph      DOT = 0x4000;
+
+    static void setGlyph(uint8_t* buffer, uint32_t digit, Glyph glyph) {
+        buffer[digit * 2] = (uint8_t)(glyph & 0xFF);
+        buffer[digit * 2 + 1] = (uint8_t)(glyph >> 8);
+    }
+
+    static Glyph getGlyph(const uint8_t* buffer, uint32_t digit) {
+        return (Glyph)(buffer[digit * 2] | (buffer[digit * 2 + 1] << 8));
+    }
+};
+
+
+/**
+    8x8 LED matrix, as on the Adafruit mini 8x8 backpack. Each
+    of its eight 'digits' is a row, with bit 0 the leftmost pixel.
+ */
+struct MatrixLayout {
+
+    typedef uint8_t Glyph;
+
+    static constexpr uint32_t   DIGITS = 8;
+    static constexpr uint32_t   WIDTH = 8;
+
+    // The backpack wires the leftmost column to the row's bit 7
+    static constexpr uint8_t columnBits(uint8_t pixels) {
+        return (uint8_t)((pixels << 7) | (pixels >> 1));
+    }
+
+    static void setGlyph(uint8_t* buffer, uint32_t digit, Glyph glyph) {
+        buffer[digit * 2] = columnBits(glyph);
+    }
+
+    static Glyph getGlyph(const uint8_t* buffer, uint32_t digit) {
+        const uint8_t bits = buffer[digit * 2];
+        return (Glyph)((bits << 1) | (bits >> 7));
+    }
+
+    static void setPixel(uint8_t* buffer, uint32_t x, uint32_t y, bool isSet) {
+        if (x >= WIDTH || y >= DIGITS) return;
+        const uint8_t bit = columnBits((uint8_t)(1 << x));
+        if (isSet) {
+            buffer[y * 2] |= bit;
+        } else {
+            buffer[y * 2] &= (uint8_t)~bit;
+        }
+    }
+};
+
+
+/**
+    24-bar, bi-colour bargraph, as on the Adafruit bargraph backpack.
+    A bar's red and green LEDs are lit together to show yellow.
+ */
+struct BargraphLayout {
+
+    typedef uint16_t Glyph;
+
+    static constexpr uint32_t   DIGITS = 0;
+    static constexpr uint32_t   BARS = 24;
+
+    static void setBar(uint8_t* buffer, uint32_t bar, BAR_COLOR color) {
+        if (bar >= BARS) return;
+
+        // Bars 0-11 use the low nibble of rows 0-2, bars 12-23 the high
+        // nibble. The red LED is in a row's low byte, green in its high
+        const uint32_t row = (bar % 12) / 4;
+        const uint8_t bit = (uint8_t)(1 << ((bar % 4) + (bar < 12 ? 0 : 4)));
+        const bool isRed = (color == BAR_COLOR::RED || color == BAR_COLOR::YELLOW);
+        const bool isGreen = (color == BAR_COLOR::GREEN || color == BAR_COLOR::YELLOW);
+        buffer[row * 2] = isRed ? (buffer[row * 2] | bit) : (buffer[row * 2] & (uint8_t)~bit);
+        buffer[row * 2 + 1] = isGreen ? (buffer[row * 2 + 1] | bit) : (buffer[row * 2 + 1] & (uint8_t)~bit);
+    }
+};
+
+
+/*
+ * FONTS
+ *
+ * Glyphs for 7-bit ASCII, held in flash. Characters a font has
+ * no sensible glyph for are blank.
+ */
+
+// For panels that don't show characters
+struct NoFont {};
+
+
+/**
+    Bits 0-6 are segments a-g, bit 7 the decimal point.
+    '*' shows a degree sign.
+ */
+struct SevenSegmentFont {
+
+    static constexpr uint8_t TABLE[128] = {
+        // 0x00-0x1F: control characters
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        //  SP     !     "     #     $     %     &     '     (     )     *     +     ,     -     .     /
+        0x00, 0x86, 0x22, 0x7E, 0x6D, 0xD2, 0x46, 0x20, 0x39, 0x0F, 0x63, 0x70, 0x10, 0x40, 0x80, 0x52,
+        //   0     1     2     3     4     5     6     7     8     9     :     ;     <     =     >     ?
+        0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x09, 0x0D, 0x61, 0x48, 0x43, 0xD3,
+        //   @     A     B     C     D     E     F     G     H     I     J     K     L     M     N     O
+        0x5F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D, 0x76, 0x30, 0x1E, 0x75, 0x38, 0x15, 0x37, 0x3F,
+        //   P     Q     R     S     T     U     V     W     X     Y     Z     [   bslsh   ]     ^     _
+        0x73, 0x6B, 0x33, 0x6D, 0x78, 0x3E, 0x3E, 0x2A, 0x76, 0x6E, 0x5B, 0x39, 0x64, 0x0F, 0x23, 0x08,
+        //   `     a     b     c     d     e     f     g     h     i     j     k     l     m     n     o
+        0x02, 0x5F, 0x7C, 0x58, 0x5E, 0x7B, 0x71, 0x6F, 0x74, 0x10, 0x0C, 0x75, 0x30, 0x14, 0x54, 0x5C,
+        //   p     q     r     s     t     u     v     w     x     y     z     {     |     }     ~   DEL
+        0x73, 0x67, 0x50, 0x6D, 0x78, 0x1C, 0x1C, 0x14, 0x76, 0x6E, 0x5B, 0x46, 0x30, 0x70, 0x01, 0x00
+    };
+};
+
+
+/**
+    Bits 0-5 are segments A-F, then G1, G2, H, J, K, L, M and N;
+    bit 14 is the decimal point.
+ */
+struct FourteenSegmentFont {
+
+    static constexpr uint16_t TABLE[128] = {
+        // 0x00-0x1F: control characters
+        0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+        0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+        0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+        0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+        //   SP       !       "       #       $       %       &       '
+        0x0000, 0x0006, 0x0220, 0x12CE, 0x12ED, 0x0C24, 0x235D, 0x0400,
+        //    (       )       *       +       ,       -       .       /
+        0x2400, 0x0900, 0x3FC0, 0x12C0, 0x0800, 0x00C0, 0x4000, 0x0C00,
+        //    0       1       2       3       4       5       6       7
+        0x0C3F, 0x0006, 0x00DB, 0x008F, 0x00E6, 0x2069, 0x00FD, 0x0007,
+        //    8       9       :       ;       <       =       >       ?
+        0x00FF, 0x00EF, 0x1200, 0x0A00, 0x2400, 0x00C8, 0x0900, 0x1083,
+        //    @       A       B       C       D       E       F       G
+        0x02BB, 0x00F7, 0x128F, 0x0039, 0x120F, 0x00F9, 0x0071, 0x00BD,
+        //    H       I       J       K       L       M       N       O
+        0x00F6, 0x1209, 0x001E, 0x2470, 0x0038, 0x0536, 0x2136, 0x003F,
+        //    P       Q       R       S       T       U       V       W
+        0x00F3, 0x203F, 0x20F3, 0x00ED, 0x1201, 0x003E, 0x0C30, 0x2836,
+        //    X       Y       Z       [   bslsh       ]       ^       _
+        0x2D00, 0x1500, 0x0C09, 0x0039, 0x2100, 0x000F, 0x0C03, 0x0008,
+        //    `       a       b       c       d       e       f       g
+        0x0100, 0x1058, 0x2078, 0x00D8, 0x088E, 0x0858, 0x0071, 0x048E,
+        //    h       i       j       k       l       m       n       o
+        0x1070, 0x1000, 0x000E, 0x3600, 0x0030, 0x10D4, 0x1050, 0x00DC,
+        //    p       q       r       s       t       u       v       w
+        0x0170, 0x0486, 0x0050, 0x2088, 0x0078, 0x001C, 0x2004, 0x2814,
+        //    x       y       z       {       |       }       ~     DEL
+        0x28C0, 0x200C, 0x0848, 0x0949, 0x1200, 0x2489, 0x0520, 0x0000
+    };
+};
+
+
+#endif  // _HT16K33_LAYOUTS_HEADER_
@@ -9,15 +9,46 @@
 #include "main.h"
 
 
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    I2C::Op         ops[I2C::MAX_TRANSACTION_OPS];
+    uint8_t         bytes[I2C::MAX_TRANSACTION_BYTES];     // The write ops' data, and the read ops' results
+    uint8_t*        destinations[I2C::MAX_TRANSACTION_OPS];// Where each read op's results are copied
+    uint32_t        opCount;
+    uint32_t        opIndex;
+    I2C::Callback   callback;
+    void*           context;
+    bool            isCancelled;                            // The submitter no longer wants the outcome
+} Transaction;
+
+
 /*
  * GLOBALS
  */
 I2C_HandleTypeDef i2c;
 
+// Queue of pending transactions. The main loop adds at `queueHead`;
+// the transfer-complete interrupt removes from `queueTail`
+static          Transaction queue[I2C::QUEUE_LENGTH];
+static volatile uint32_t    queueHead = 0;
+static volatile uint32_t    queueTail = 0;
+static volatile bool        busy = false;
+static volatile uint32_t    errorCount = 0;
+
 
 // Required on STM32 HAL callouts implemented in C++
 #ifdef __cplusplus
-extern "C" void HAL_I2C_MspInit(I2C_HandleTypeDef *i2c);
+extern "C" {
+    void HAL_I2C_MspInit(I2C_HandleTypeDef *i2c);
+    void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *i2c);
+    void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *i2c);
+    void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *i2c);
+    void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *i2c);
+    void I2C1_EV_IRQHandler(void);
+    void I2C1_ER_IRQHandler(void);
+}
 #endif
 
 
@@ -26,35 +57,22 @@ namespace I2C {
 /**
  * @brief Check for presence of a known device by its I2C address.
  *
+ * This doesn't wait for an absent device: the display driver
+ * tolerates bus errors, so the clock carries on without it.
+ *
  * @param address: The device's address.
  *
  * @returns `true` if the device is present, otherwise `false`.
  */
-static bool check(uint8_t address) {
+bool probe(uint8_t address) {
 
-    uint8_t timeoutCount = 0;
+    constexpr uint32_t TRIALS = 3;
+    constexpr uint32_t TIMEOUT_MS = 10;
 
-    while(true) {
-        HAL_StatusTypeDef status = HAL_I2C_IsDeviceReady(&i2c, (uint16_t)(address << 1), 1, 100);
-        if (status == HAL_OK) {
-            return true;
-        } else {
-            uint32_t err = HAL_I2C_GetError(&i2c);
-            server_error("HAL_I2C_IsDeviceReady():  %i", status);
-            server_error("HAL_I2C_GetError():       %li", err);
-        }
-
-        // Flash the LED eight times on device not ready
-        for (uint8_t i = 0 ; i < 8 ; ++i) {
-            HAL_GPIO_TogglePin(LED_GPIO_BANK, LED_GPIO_PIN);
-            HAL_Delay(100);
-        }
-
-        HAL_Delay(1000);
-        timeoutCount++;
-        if (timeoutCount > 10) break;
-    }
+    HAL_StatusTypeDef status = HAL_I2C_IsDeviceReady(&i2c, (uint16_t)(address << 1), TRIALS, TIMEOUT_MS);
+    if (status == HAL_OK) return true;
 
+    LOG_DEBUG(I2C, "No device at 0x%02x: %i, error %li", address, status, HAL_I2C_GetError(&i2c));
     return false;
 }
 
@@ -62,9 +80,10 @@ static bool check(uint8_t address) {
 /**
  * @brief Set up the I2C block.
  *
- * Takes values from #defines set in `i2c.h`
+ * Takes values from #defines set in `i2c.h`. Devices are
+ * probed for separately, with `probe()`.
  */
-void setup(uint8_t targetAddress) {
+void setup(void) {
 
     // I2C1 pins are:
     //   SDA -> PB9
@@ -81,38 +100,338 @@ void setup(uint8_t targetAddress) {
 
     // Initialize the I2C itself with the i2c handle
     if (HAL_I2C_Init(&i2c) != HAL_OK) {
-        server_error("[I2C] INITIALIZATION FAILURE");
+        LOG_ERROR(I2C, "[I2C] INITIALIZATION FAILURE");
         return;
     }
 
-    // I2C is up, so check peripheral availability
-    check(targetAddress);
+    // Enable the I2C event and error interrupts
+    // that drive queued transfers
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+
+/**
+ * @brief Start the current operation of a transaction.
+ *
+ * Operations after the first begin with a repeated START and
+ * only the last ends with a STOP, so the whole transaction
+ * holds the bus.
+ *
+ * @param transaction: The transaction.
+ *
+ * @returns `true` if the operation started, otherwise `false`.
+ */
+static bool startOp(Transaction& transaction) {
+
+    const Op& op = transaction.ops[transaction.opIndex];
+    const bool isFirst = (transaction.opIndex == 0);
+    const bool isLast = (transaction.opIndex == transaction.opCount - 1);
+    uint32_t options = I2C_OTHER_FRAME;
+    if (isFirst) {
+        options = isLast ? I2C_FIRST_AND_LAST_FRAME : I2C_FIRST_FRAME;
+    } else if (isLast) {
+        options = I2C_OTHER_AND_LAST_FRAME;
+    }
+
+    const auto address = (uint16_t)(op.address << 1);
+    HAL_StatusTypeDef status = (op.type == OP::WRITE)
+        ? HAL_I2C_Master_Seq_Transmit_IT(&i2c, address, op.data, op.count, options)
+        : HAL_I2C_Master_Seq_Receive_IT(&i2c, address, op.data, op.count, options);
+    return (status == HAL_OK);
 }
 
 
 /**
- * @brief Convenience function to write a single byte to the bus.
+ * @brief Retire the transaction at the tail of the queue
+ *        and tell its submitter how it went.
+ *
+ * Read results are copied out only on success, and not at all
+ * if the submitter has cancelled the transaction.
+ *
+ * @param success: Did every operation complete?
+ */
+static void finish(bool success) {
+
+    Transaction& transaction = queue[queueTail % QUEUE_LENGTH];
+    if (!success) errorCount = errorCount + 1;
+    if (!transaction.isCancelled) {
+        if (success) {
+            for (uint32_t i = 0 ; i < transaction.opCount ; ++i) {
+                const Op& op = transaction.ops[i];
+                if (op.type == OP::READ) memcpy(transaction.destinations[i], op.data, op.count);
+            }
+        }
+
+        if (transaction.callback != nullptr) transaction.callback(success, transaction.context);
+    }
+
+    queueTail = queueTail + 1;
+}
+
+
+/**
+ * @brief Start the transaction at the tail of the queue, if there is one.
+ *
+ * Called with the I2C interrupts unable to pre-empt the caller:
+ * either from the main loop with interrupts disabled, or from
+ * the I2C interrupt itself.
+ */
+static void startNext(void) {
+
+    while (queueTail != queueHead) {
+        Transaction& transaction = queue[queueTail % QUEUE_LENGTH];
+        transaction.opIndex = 0;
+        if (!transaction.isCancelled && startOp(transaction)) {
+            busy = true;
+            return;
+        }
+
+        // Cancelled, or could not start this one, so drop it and try the next
+        finish(false);
+    }
+
+    busy = false;
+}
+
+
+/**
+ * @brief Advance the active transaction after an operation ends.
+ *
+ * Called from the I2C interrupt.
+ *
+ * @param success: Did the operation complete?
+ */
+static void opComplete(bool success) {
+
+    Transaction& transaction = queue[queueTail % QUEUE_LENGTH];
+    if (success && ++transaction.opIndex < transaction.opCount) {
+        if (startOp(transaction)) return;
+        success = false;
+    }
+
+    finish(success);
+    startNext();
+}
+
+
+/**
+ * @brief Queue a list of reads and writes to be performed as
+ *        a single bus transaction, in the background.
+ *
+ * Write data is copied, so the caller may reuse its buffers at
+ * once. Reads fill the queue's own buffer, which is copied to the
+ * caller's read buffers on success, just before the callback is
+ * made. So read buffers must stay valid until then.
+ *
+ * @param ops:      The operations, in order.
+ * @param opCount:  The number of operations.
+ * @param callback: Optional function called when the transaction
+ *                  completes or fails. This is usually made from the
+ *                  I2C interrupt. If the bus can't start the transaction,
+ *                  it is made before `submit()` returns, in the caller's
+ *                  context but with interrupts disabled.
+ * @param context:  Value passed to the callback.
+ *
+ * @returns `true` if the transaction was queued, otherwise `false`.
+ */
+bool submit(const Op* ops, uint32_t opCount, Callback callback, void* context) {
+
+    if (opCount == 0 || opCount > MAX_TRANSACTION_OPS) return false;
+
+    if (queueHead - queueTail >= QUEUE_LENGTH) {
+        LOG_ERROR(I2C, "[I2C] TRANSACTION QUEUE FULL");
+        return false;
+    }
+
+    Transaction& transaction = queue[queueHead % QUEUE_LENGTH];
+    uint32_t byteCount = 0;
+    for (uint32_t i = 0 ; i < opCount ; ++i) {
+        Op& op = transaction.ops[i];
+        op = ops[i];
+        if (op.count == 0) return false;
+
+        if (byteCount + op.count > MAX_TRANSACTION_BYTES) return false;
+        transaction.destinations[i] = nullptr;
+        if (op.type == OP::WRITE) {
+            memcpy(&transaction.bytes[byteCount], ops[i].data, op.count);
+        } else {
+            transaction.destinations[i] = ops[i].data;
+        }
+
+        op.data = &transaction.bytes[byteCount];
+        byteCount += op.count;
+    }
+
+    transaction.opCount = opCount;
+    transaction.callback = callback;
+    transaction.context = context;
+    transaction.isCancelled = false;
+
+    // Publish the transaction and start the bus if it is idle
+    __disable_irq();
+    queueHead = queueHead + 1;
+    if (!busy) startNext();
+    __enable_irq();
+    return true;
+}
+
+
+/**
+ * @brief Give up on a queued transaction: its callback won't be made,
+ *        nor its read buffers written. If it is on the bus, the transfer
+ *        is aborted, so it doesn't hold up the transactions behind it;
+ *        if it hasn't started, it is dropped when it reaches the bus.
+ *
+ * @param ticket: The transaction's place in the queue, the value
+ *                of `queueHead` when it was submitted.
+ *
+ * @returns `true` if it was cancelled, or `false` if it had already finished.
+ */
+static bool cancel(uint32_t ticket) {
+
+    __disable_irq();
+    const bool isQueued = (ticket - queueTail < queueHead - queueTail);
+    if (isQueued) {
+        Transaction& transaction = queue[ticket % QUEUE_LENGTH];
+        transaction.isCancelled = true;
+
+        // The abort completes in the I2C interrupt, which retires the transaction
+        if (ticket == queueTail && busy) {
+            const Op& op = transaction.ops[transaction.opIndex];
+            HAL_I2C_Master_Abort_IT(&i2c, (uint16_t)(op.address << 1));
+        }
+    }
+
+    __enable_irq();
+    return isQueued;
+}
+
+
+/**
+ * @brief Perform a list of reads and writes as a single bus
+ *        transaction, waiting for it to complete.
+ *
+ * If it times out, the transaction is cancelled, so the caller's
+ * read buffers are never written after this returns.
+ *
+ * @param ops:       The operations, in order.
+ * @param opCount:   The number of operations.
+ * @param timeoutMs: The maximum period to wait.
+ *
+ * @returns `true` if every operation completed, otherwise `false`.
+ */
+bool transact(const Op* ops, uint32_t opCount, uint32_t timeoutMs) {
+
+    // Outcome, set by the callback: 0 = pending, 1 = success, 2 = failure.
+    // Only the main loop submits, so this transaction takes the queue's head
+    volatile uint32_t result = 0;
+    auto done = [](bool success, void* context) { *(volatile uint32_t*)context = success ? 1 : 2; };
+    const uint32_t ticket = queueHead;
+    if (!submit(ops, opCount, done, (void*)&result)) return false;
+
+    const uint32_t startTick = HAL_GetTick();
+    while (result == 0) {
+        if (HAL_GetTick() - startTick > timeoutMs) {
+            // It may have finished just now; if not, stop it writing to `result`
+            if (cancel(ticket)) {
+                LOG_ERROR(I2C, "[I2C] TRANSACTION TIMED OUT");
+                return false;
+            }
+
+            break;
+        }
+
+        __WFI();
+    }
+
+    return (result == 1);
+}
+
+
+/**
+ * @brief Queue a block of bytes to be written to the bus.
  *
  * @param address: The I2C address of the device to write to.
- * @param byte:    The byte to send.
+ * @param data:    Pointer to the bytes to send.
+ * @param count:   The number of bytes to send.
+ *
+ * @returns `true` if the block was queued, otherwise `false`.
  */
-void writeByte(uint8_t address, uint8_t byte) {
+bool writeBlock(uint8_t address, const uint8_t *data, uint8_t count) {
+
+    PROFILE_SCOPE(PROFILE_ZONE_I2C_WRITE);
 
-    HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(&i2c, (uint16_t)(address << 1), &byte, 1, 100);
-    if (status != HAL_OK) server_error("[I2C] WRITE BYTE FAILURE");
+    const Op op = { address, OP::WRITE, count, (uint8_t*)data };
+    return submit(&op, 1);
 }
 
 
 /**
- * @brief Convenience function to write a single byte to the bus.
+ * @brief Convenience function to queue a single byte to be written to the bus.
  *
  * @param address: The I2C address of the device to write to.
  * @param byte:    The byte to send.
+ *
+ * @returns `true` if the byte was queued, otherwise `false`.
  */
-void writeBlock(uint8_t address, uint8_t *data, uint8_t count) {
+bool writeByte(uint8_t address, uint8_t byte) {
 
-    HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(&i2c, (uint16_t)(address << 1), data, count, 100);
-    if (status != HAL_OK) server_error("[I2C] WRITE BLOCK FAILURE");
+    return writeBlock(address, &byte, 1);
+}
+
+
+/**
+ * @brief Read one or more bytes from a device register, using a
+ *        repeated START between the register write and the read.
+ *
+ * @param address: The I2C address of the device to read from.
+ * @param reg:     The register to read.
+ * @param data:    Destination for the bytes read.
+ * @param count:   The number of bytes to read.
+ *
+ * @returns `true` if the bytes were read, otherwise `false`.
+ */
+bool readRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t count) {
+
+    const Op ops[2] = {
+        { address, OP::WRITE, 1, &reg },
+        { address, OP::READ, count, data }
+    };
+
+    return transact(ops, 2, 100);
+}
+
+
+/**
+ * @brief Wait for all queued transactions to complete.
+ *
+ * @param timeoutMs: The maximum period to wait.
+ *
+ * @returns `true` if the queue emptied, otherwise `false`.
+ */
+bool flush(uint32_t timeoutMs) {
+
+    const uint32_t startTick = HAL_GetTick();
+    while (busy) {
+        if (HAL_GetTick() - startTick > timeoutMs) return false;
+        __WFI();
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Get the number of queued transactions that have failed.
+ *
+ * @returns The running count of failures.
+ */
+uint32_t getErrorCount(void) {
+
+    return errorCount;
 }
 
 
@@ -135,7 +454,7 @@ void HAL_I2C_MspInit([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
 
     // Initialize U5 peripheral clock
     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK) {
-        server_error("[I2C] I2C PERIPHERAL CLOCK COULD NOT BE SET");
+        LOG_ERROR(I2C, "[I2C] I2C PERIPHERAL CLOCK COULD NOT BE SET");
         return;
     }
 
@@ -158,3 +477,71 @@ void HAL_I2C_MspInit([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
     // Enable the I2C1 clock
     __HAL_RCC_I2C1_CLK_ENABLE()
 }
+
+
+/**
+ * @brief HAL-called function on completion of a write operation.
+ *
+ * @param i2cBus: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MasterTxCpltCallback([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
+
+    I2C::opComplete(true);
+}
+
+
+/**
+ * @brief HAL-called function on completion of a read operation.
+ *
+ * @param i2cBus: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MasterRxCpltCallback([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
+
+    I2C::opComplete(true);
+}
+
+
+/**
+ * @brief HAL-called function on failure of an operation.
+ *
+ * Logging is not possible here, so the failure is counted
+ * and the rest of the transaction dropped.
+ *
+ * @param i2cBus: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_ErrorCallback([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
+
+    I2C::opComplete(false);
+}
+
+
+/**
+ * @brief HAL-called function once an operation has been aborted.
+ *
+ * Only cancelled transactions are aborted, so this just drops the
+ * rest of the transaction and moves on to the next.
+ *
+ * @param i2cBus: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_AbortCpltCallback([[maybe_unused]] I2C_HandleTypeDef *i2cBus) {
+
+    I2C::opComplete(false);
+}
+
+
+/**
+ * @brief The I2C1 event interrupt handler.
+ */
+void I2C1_EV_IRQHandler(void) {
+
+    HAL_I2C_EV_IRQHandler(&i2c);
+}
+
+
+/**
+ * @brief The I2C1 error interrupt handler.
+ */
+void I2C1_ER_IRQHandler(void) {
+
+    HAL_I2C_ER_IRQHandler(&i2c);
+}
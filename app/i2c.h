@@ -15,9 +15,57 @@
  */
 namespace I2C {
 
-    void        setup(uint8_t address);
-    void        writeByte(uint8_t address, uint8_t byte);
-    void        writeBlock(uint8_t address, uint8_t *data, uint8_t count);
+    /*
+     * CONSTANTS
+     */
+    // Most operations, and most bytes written or read, in one transaction.
+    // A display group updates up to eight panels in one transaction
+    constexpr uint32_t  MAX_TRANSACTION_OPS = 8;
+    constexpr uint32_t  MAX_TRANSACTION_BYTES = 48;
+    // Transactions that may be pending at any one time
+    constexpr uint32_t  QUEUE_LENGTH = 8;
+
+
+    /*
+     * ENUMERATIONS
+     */
+    enum class OP: uint8_t {
+        WRITE = 0,
+        READ
+    };
+
+
+    /*
+     * STRUCTURES
+     */
+    // One step of a transaction. For writes, `data` is copied when
+    // the transaction is submitted; for reads, it is written when the
+    // transaction completes, so must remain valid until then
+    typedef struct {
+        uint8_t     address;
+        OP          type;
+        uint8_t     count;
+        uint8_t*    data;
+    } Op;
+
+    // Called when a transaction completes or fails: usually from the I2C
+    // interrupt, but from within `submit()`, with interrupts disabled,
+    // if the bus can't start it. Either way, keep to the ISR rules
+    typedef void (*Callback)(bool success, void* context);
+
+
+    /*
+     * PROTOTYPES
+     */
+    void        setup(void);
+    bool        probe(uint8_t address);
+    bool        submit(const Op* ops, uint32_t opCount, Callback callback = nullptr, void* context = nullptr);
+    bool        transact(const Op* ops, uint32_t opCount, uint32_t timeoutMs);
+    bool        writeByte(uint8_t address, uint8_t byte);
+    bool        writeBlock(uint8_t address, const uint8_t *data, uint8_t count);
+    bool        readRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t count);
+    bool        flush(uint32_t timeoutMs);
+    uint32_t    getErrorCount(void);
 }
 
 
@@ -0,0 +1,99 @@
+/*
+ * Microvisor Clock Demo -- Idle namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t STATS_WINDOW_MS = 10000;
+
+
+/*
+ * GLOBALS
+ */
+static volatile bool        wakePending = false;
+static          uint32_t    windowStartTick = 0;
+static          uint32_t    windowIdleMs = 0;
+static          uint32_t    windowWakeups = 0;
+static          IdleStats   lastStats = { 100, 0, 0 };
+
+
+namespace Idle {
+
+/**
+ * @brief Close the current accounting window if it has run its course.
+ *
+ * @param now: The current HAL tick.
+ */
+static void updateStats(uint32_t now) {
+
+    const uint32_t elapsed = now - windowStartTick;
+    if (elapsed < STATS_WINDOW_MS) return;
+
+    if (windowIdleMs > elapsed) windowIdleMs = elapsed;
+    lastStats.busyPercent = ((elapsed - windowIdleMs) * 100) / elapsed;
+    lastStats.wakeupsPerSecond = (windowWakeups * 1000) / elapsed;
+    lastStats.windowMs = elapsed;
+
+    windowStartTick = now;
+    windowIdleMs = 0;
+    windowWakeups = 0;
+}
+
+
+/**
+ * @brief Sleep the CPU until the specified HAL tick, or until
+ *        a notification calls `wake()`, whichever comes first.
+ *
+ * The CPU is woken by every interrupt, including the 1ms HAL
+ * tick, so idle time is measured with tick resolution.
+ *
+ * @param deadlineTick: The HAL tick at which to return.
+ */
+void waitUntil(uint32_t deadlineTick) {
+
+    while ((int32_t)(deadlineTick - HAL_GetTick()) > 0 && !wakePending) {
+        const uint32_t sleepTick = HAL_GetTick();
+        __WFI();
+
+        const uint32_t now = HAL_GetTick();
+        windowIdleMs += (now - sleepTick);
+        windowWakeups++;
+        updateStats(now);
+    }
+
+    wakePending = false;
+}
+
+
+/**
+ * @brief Cut short any current or upcoming `waitUntil()`.
+ *
+ * Safe to call from an ISR.
+ */
+void wake(void) {
+
+    wakePending = true;
+}
+
+
+/**
+ * @brief Get the CPU duty cycle and wakeup rate measured
+ *        over the most recently completed window.
+ *
+ * @returns The idle statistics.
+ */
+IdleStats getStats(void) {
+
+    return lastStats;
+}
+
+
+}   // namespace Idle
@@ -0,0 +1,34 @@
+/*
+ * Microvisor Clock Demo -- Idle namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _IDLE_HEADER_
+#define _IDLE_HEADER_
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    busyPercent;        // Share of the last window the CPU was awake (0-100)
+    uint32_t    wakeupsPerSecond;   // Average number of wakeups per second over the last window
+    uint32_t    windowMs;           // Length of the last completed window
+} IdleStats;
+
+
+/*
+ * PROTOTYPES
+ */
+namespace Idle {
+
+    void        waitUntil(uint32_t deadlineTick);
+    void        wake(void);
+    IdleStats   getStats(void);
+}
+
+
+#endif  // _IDLE_HEADER_
@@ -6,7 +6,9 @@
  * Licence: MIT
  *
  */
+#define LOGGING_IMPLEMENTATION
 #include "logging.h"
+#include "profile.h"
 
 
 /*
@@ -15,6 +17,10 @@
 static void log_start(void);
 static void log_service_setup(void);
 static void post_log(bool is_err, const char* format_string, va_list args);
+#if LOG_TOKENIZED
+static uint32_t put_varint(uint8_t* record, uint32_t index, uint64_t value);
+static uint32_t encode_args(uint8_t* record, uint32_t index, const char* arg_types, va_list args);
+#endif
 
 
 /*
@@ -24,9 +30,13 @@ static void post_log(bool is_err, const char* format_string, va_list args);
 static uint8_t log_buffer[LOG_BUFFER_SIZE_B] __attribute__((aligned(512))) = {0};
 static uint32_t log_state = USER_HANDLE_LOGGING_OFF;
 
+// Start of the tokenized logging format string section, set by the linker
+// in `log_formats.ld`. The section isn't loaded, so only its address is used
+#if LOG_TOKENIZED
+extern const char __start_log_formats[];
+#endif
+
 // Entities for local serial logging
-// Declared in `uart_logging.c`
-extern UART_HandleTypeDef uart;
 static bool uart_available = false;
 
 
@@ -104,6 +114,7 @@ void server_error(const char* format_string, ...) {
  */
 static void post_log(bool is_err, const char* format_string, va_list args) {
 
+    PROFILE_BEGIN(PROFILE_ZONE_LOG_POST);
     log_start();
     char buffer[LOG_MESSAGE_MAX_LEN_B] = {0};
 
@@ -118,4 +129,150 @@ static void post_log(bool is_err, const char* format_string, va_list args) {
 
     // Do we output via UART too?
     if (uart_available) log_uart_output(buffer);
+    PROFILE_END(PROFILE_ZONE_LOG_POST);
+}
+
+
+#if LOG_TOKENIZED
+/**
+ * @brief Append an unsigned LEB128 varint to a log record.
+ *
+ * @param record Pointer to the record buffer
+ * @param index  Offset at which to write
+ * @param value  The value to encode
+ *
+ * @returns The offset after the encoded value, or
+ *          LOG_RECORD_MAX_LEN_B + 1 if the record is full.
+ */
+static uint32_t put_varint(uint8_t* record, uint32_t index, uint64_t value) {
+
+    do {
+        if (index >= LOG_RECORD_MAX_LEN_B) return LOG_RECORD_MAX_LEN_B + 1;
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        record[index++] = byte | (value != 0 ? 0x80 : 0x00);
+    } while (value != 0);
+
+    return index;
 }
+
+
+/**
+ * @brief Encode a log call's arguments, in the order given by
+ *        the argument type codes made at compile time.
+ *
+ * Signed integers are zig-zag encoded varints, unsigned integers and
+ * pointers are plain varints, strings are a length varint followed
+ * by the bytes (truncated to LOG_STRING_ARG_MAX_LEN_B), and doubles
+ * are eight little-endian bytes.
+ *
+ * @param record    Pointer to the record buffer
+ * @param index     Offset at which to start writing
+ * @param arg_types The arguments' `LOG_ARG_` codes
+ * @param args      va_list of args from previous call
+ *
+ * @returns The offset after the encoded arguments.
+ */
+static uint32_t encode_args(uint8_t* record, uint32_t index, const char* arg_types, va_list args) {
+
+    for (const char* type = arg_types ; *type != LOG_ARG_END && index <= LOG_RECORD_MAX_LEN_B ; ++type) {
+        switch (*type) {
+            case LOG_ARG_INT:
+            case LOG_ARG_INT64: {
+                int64_t value = (*type == LOG_ARG_INT64) ? va_arg(args, long long) : va_arg(args, int);
+                index = put_varint(record, index, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+                break;
+            }
+            case LOG_ARG_UINT:
+                index = put_varint(record, index, va_arg(args, unsigned int));
+                break;
+            case LOG_ARG_UINT64:
+                index = put_varint(record, index, va_arg(args, unsigned long long));
+                break;
+            case LOG_ARG_POINTER:
+                index = put_varint(record, index, (uint64_t)(uintptr_t)va_arg(args, void*));
+                break;
+            case LOG_ARG_STRING: {
+                const char* string = va_arg(args, const char*);
+                if (string == NULL) string = "(null)";
+                uint32_t length = strnlen(string, LOG_STRING_ARG_MAX_LEN_B);
+                if (index + length + 1 > LOG_RECORD_MAX_LEN_B) length = 0;
+                index = put_varint(record, index, length);
+                if (index <= LOG_RECORD_MAX_LEN_B) {
+                    memcpy(&record[index], string, length);
+                    index += length;
+                }
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double value = va_arg(args, double);
+                if (index + 8 > LOG_RECORD_MAX_LEN_B) return LOG_RECORD_MAX_LEN_B + 1;
+                memcpy(&record[index], &value, 8);
+                index += 8;
+                break;
+            }
+            default:
+                // Unknown type: stop rather than misread the arguments
+                return index;
+        }
+    }
+
+    return index;
+}
+
+
+/**
+ * @brief Issue a tokenized log message: the format string's token
+ *        and its raw arguments, not the formatted text.
+ *
+ * Records are sent as `~` followed by the base64-encoded bytes:
+ * a flags byte (bit 0 set for errors), the token as a varint, then
+ * the arguments. Use `tools/log_decode.py` to turn them back into text.
+ * The format strings aren't in the image, so the UART gets the same
+ * records, to be decoded in the same way.
+ *
+ * Call via the `server_log()` and `server_error()` macros, which
+ * make the call's entry in the `log_formats` section.
+ *
+ * @param is_err       Is the message an error?
+ * @param format_entry The call's entry in the `log_formats` section
+ * @param arg_types    The arguments' `LOG_ARG_` codes
+ * @param ...          Optional injectable values
+ */
+void server_log_token(bool is_err, const void* format_entry, const char* arg_types, ...) {
+
+    static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint8_t record[LOG_RECORD_MAX_LEN_B + 1];
+    char text[(LOG_RECORD_MAX_LEN_B + 2) / 3 * 4 + 2];
+
+    log_start();
+
+    // Build the binary record
+    record[0] = is_err ? 0x01 : 0x00;
+    uint32_t length = put_varint(record, 1, (uint64_t)((const char*)format_entry - __start_log_formats));
+    va_list args;
+    va_start(args, arg_types);
+    length = encode_args(record, length, arg_types, args);
+    va_end(args);
+    if (length > LOG_RECORD_MAX_LEN_B) length = LOG_RECORD_MAX_LEN_B;
+
+    // Encode it as printable text for the log stream
+    uint32_t t = 0;
+    text[t++] = LOG_RECORD_PREFIX;
+    for (uint32_t i = 0 ; i < length ; i += 3) {
+        const uint32_t remaining = length - i;
+        const uint32_t bits = (record[i] << 16) | (remaining > 1 ? record[i + 1] << 8 : 0) | (remaining > 2 ? record[i + 2] : 0);
+        text[t++] = BASE64[(bits >> 18) & 0x3F];
+        text[t++] = BASE64[(bits >> 12) & 0x3F];
+        text[t++] = remaining > 1 ? BASE64[(bits >> 6) & 0x3F] : '=';
+        text[t++] = remaining > 2 ? BASE64[bits & 0x3F] : '=';
+    }
+
+    mvServerLog((const uint8_t*)text, (uint16_t)t);
+
+    if (uart_available) {
+        text[t] = 0;
+        log_uart_output(text);
+    }
+}
+#endif
@@ -40,6 +40,25 @@
 #define     LOG_MESSAGE_MAX_LEN_B               1024
 #define     LOG_BUFFER_SIZE_B                   4096
 
+// Tokenized logging: largest binary record, and longest string argument
+#define     LOG_RECORD_MAX_LEN_B                96
+#define     LOG_STRING_ARG_MAX_LEN_B            32
+// Marks a tokenized record in the log stream
+#define     LOG_RECORD_PREFIX                   '~'
+// Most arguments to one tokenized log call
+#define     LOG_ARGS_MAX                        12
+
+// Tokenized logging: the type of each argument, after the usual
+// promotions of variadic arguments, coded as one byte
+#define     LOG_ARG_END                         '\0'
+#define     LOG_ARG_INT                         'i'     // int, and anything promoted to int
+#define     LOG_ARG_UINT                        'u'
+#define     LOG_ARG_INT64                       'I'
+#define     LOG_ARG_UINT64                      'U'
+#define     LOG_ARG_DOUBLE                      'f'
+#define     LOG_ARG_STRING                      's'
+#define     LOG_ARG_POINTER                     'p'
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,11 +70,182 @@ extern "C" {
  */
 void            server_log(const char* format_string, ...);
 void            server_error(const char* format_string, ...);
+#if LOG_TOKENIZED
+void            server_log_token(bool is_err, const void* format_entry, const char* arg_types, ...);
+#endif
+// Never defined: only named in `sizeof` by compiled-out log calls
+int             log_discard(const char* format_string, ...);
+
+
+/*
+ * TOKENIZED LOGGING
+ *
+ * When LOG_TOKENIZED is true, each log call gets an entry in the
+ * `log_formats` ELF section: its argument types, as a string of
+ * `LOG_ARG_` codes, then its format string. The entry's offset in
+ * the section is its token. Only the token and the raw argument
+ * values are sent, as a compact binary record. `tools/log_decode.py`
+ * rebuilds the text from the log stream and the app's .elf file.
+ *
+ * `log_formats.ld` keeps the section out of the image, so the format
+ * strings take no flash. The argument types are worked out at compile
+ * time, and a copy is kept in flash for the encoder.
+ *
+ * Format strings must be string literals.
+ */
+#if LOG_TOKENIZED && !defined(LOGGING_IMPLEMENTATION)
+
+#define     LOG_FORMAT_SECTION                  __attribute__((section("log_formats"), used))
+
+#define server_log(format_string, ...) do { \
+            LOG_TOKEN_ENTRY(format_string, LOG_ARG_TYPES(LOG_ARG_COUNT(_, ##__VA_ARGS__), ##__VA_ARGS__)); \
+            if (LOG_DEBUG_MESSAGES) server_log_token(false, &log_format, log_types, ##__VA_ARGS__); \
+        } while (0)
+
+#define server_error(format_string, ...) do { \
+            LOG_TOKEN_ENTRY(format_string, LOG_ARG_TYPES(LOG_ARG_COUNT(_, ##__VA_ARGS__), ##__VA_ARGS__)); \
+            server_log_token(true, &log_format, log_types, ##__VA_ARGS__); \
+        } while (0)
 
+// The argument types, for the encoder, and the section entry, for the decoder
+#define LOG_TOKEN_ENTRY(format_string, arg_types) \
+            static const char log_types[] = { arg_types LOG_ARG_END }; \
+            static const struct { \
+                char types[sizeof(log_types)]; \
+                char format[sizeof(format_string)]; \
+            } log_format LOG_FORMAT_SECTION = { { arg_types LOG_ARG_END }, format_string }
+
+// Count the arguments, then apply LOG_ARG_TYPE() to each, up to LOG_ARGS_MAX.
+// The leading `_` lets an empty argument list count as zero
+#define LOG_ARG_COUNT(...)          LOG_ARG_COUNT_PICK(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_ARG_COUNT_PICK(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, count, ...) count
+#define LOG_ARG_TYPES(count, ...)   LOG_ARG_TYPES_PASTE(count, __VA_ARGS__)
+#define LOG_ARG_TYPES_PASTE(count, ...) LOG_ARG_TYPES_##count(__VA_ARGS__)
+#define LOG_ARG_TYPES_0(...)
+#define LOG_ARG_TYPES_1(a)          LOG_ARG_TYPE(a),
+#define LOG_ARG_TYPES_2(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_1(__VA_ARGS__)
+#define LOG_ARG_TYPES_3(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_2(__VA_ARGS__)
+#define LOG_ARG_TYPES_4(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_3(__VA_ARGS__)
+#define LOG_ARG_TYPES_5(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_4(__VA_ARGS__)
+#define LOG_ARG_TYPES_6(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_5(__VA_ARGS__)
+#define LOG_ARG_TYPES_7(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_6(__VA_ARGS__)
+#define LOG_ARG_TYPES_8(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_7(__VA_ARGS__)
+#define LOG_ARG_TYPES_9(a, ...)     LOG_ARG_TYPE(a), LOG_ARG_TYPES_8(__VA_ARGS__)
+#define LOG_ARG_TYPES_10(a, ...)    LOG_ARG_TYPE(a), LOG_ARG_TYPES_9(__VA_ARGS__)
+#define LOG_ARG_TYPES_11(a, ...)    LOG_ARG_TYPE(a), LOG_ARG_TYPES_10(__VA_ARGS__)
+#define LOG_ARG_TYPES_12(a, ...)    LOG_ARG_TYPE(a), LOG_ARG_TYPES_11(__VA_ARGS__)
 
 #ifdef __cplusplus
+#define LOG_ARG_TYPE(arg)           log_arg_type<std::decay<decltype(arg)>::type>()
+#else
+#define LOG_ARG_TYPE(arg)           _Generic((arg), \
+            _Bool: LOG_ARG_INT, char: LOG_ARG_INT, signed char: LOG_ARG_INT, unsigned char: LOG_ARG_INT, \
+            short: LOG_ARG_INT, unsigned short: LOG_ARG_INT, int: LOG_ARG_INT, unsigned int: LOG_ARG_UINT, \
+            long: (sizeof(long) > sizeof(int) ? LOG_ARG_INT64 : LOG_ARG_INT), \
+            unsigned long: (sizeof(long) > sizeof(int) ? LOG_ARG_UINT64 : LOG_ARG_UINT), \
+            long long: LOG_ARG_INT64, unsigned long long: LOG_ARG_UINT64, \
+            float: LOG_ARG_DOUBLE, double: LOG_ARG_DOUBLE, \
+            char*: LOG_ARG_STRING, const char*: LOG_ARG_STRING, \
+            default: LOG_ARG_POINTER)
+#endif
+
+#endif
+
+
+/*
+ * PER-MODULE LOG LEVELS
+ *
+ * Log through `LOG_ERROR(module, ...)` and `LOG_DEBUG(module, ...)`.
+ * Each module's level is chosen at build time by defining
+ * `LOG_LEVEL_<module>` -- see the top-level `CMakeLists.txt`. Calls
+ * below that level are removed by the preprocessor, so neither the
+ * call nor its format string reach the binary, even at -O0.
+ *
+ * Levels must be given as a `LOG_LEVEL_` name or its 0-2 value.
+ */
+#define     LOG_LEVEL_NONE                      0
+#define     LOG_LEVEL_ERROR                     1
+#define     LOG_LEVEL_DEBUG                     2
+
+// Modules with no level set follow LOG_DEBUG_MESSAGES
+#if LOG_DEBUG_MESSAGES
+#define     LOG_LEVEL_DEFAULT                   LOG_LEVEL_DEBUG
+#else
+#define     LOG_LEVEL_DEFAULT                   LOG_LEVEL_ERROR
+#endif
+
+#ifndef LOG_LEVEL_APP
+#define     LOG_LEVEL_APP                       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_I2C
+#define     LOG_LEVEL_I2C                       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_DISPLAY
+#define     LOG_LEVEL_DISPLAY                   LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_CONFIG
+#define     LOG_LEVEL_CONFIG                    LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_NET
+#define     LOG_LEVEL_NET                       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_CLOCK
+#define     LOG_LEVEL_CLOCK                     LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_STORE
+#define     LOG_LEVEL_STORE                     LOG_LEVEL_DEFAULT
+#endif
+
+#define LOG_ERROR(module, ...)      LOG_AT_LEVEL(LOG_LEVEL_##module, 1, server_error, __VA_ARGS__)
+#define LOG_DEBUG(module, ...)      LOG_AT_LEVEL(LOG_LEVEL_##module, 2, server_log, __VA_ARGS__)
+
+// The extra expansion steps turn the module's level into a bare digit
+// before it is pasted into a lookup of whether the call is enabled
+#define LOG_AT_LEVEL(level, min, log_function, ...) \
+            LOG_EMIT(LOG_ENABLED(level, min), log_function, __VA_ARGS__)
+#define LOG_ENABLED(level, min)     LOG_ENABLED_PASTE(level, min)
+#define LOG_ENABLED_PASTE(level, min) LOG_ENABLED_##level##_##min
+#define LOG_EMIT(enabled, log_function, ...) LOG_EMIT_PASTE(enabled, log_function, __VA_ARGS__)
+#define LOG_EMIT_PASTE(enabled, log_function, ...) LOG_EMIT_##enabled(log_function, __VA_ARGS__)
+
+#define LOG_ENABLED_0_1             0
+#define LOG_ENABLED_0_2             0
+#define LOG_ENABLED_1_1             1
+#define LOG_ENABLED_1_2             0
+#define LOG_ENABLED_2_1             1
+#define LOG_ENABLED_2_2             1
+
+// A disabled call generates no code, but its arguments still count as used
+#define LOG_EMIT_0(log_function, ...) do { (void)sizeof(log_discard(__VA_ARGS__)); } while (0)
+#define LOG_EMIT_1(log_function, ...) log_function(__VA_ARGS__)
+
+
+#ifdef __cplusplus
+}
+
+
+#if LOG_TOKENIZED
+#include <type_traits>
+
+/**
+ * @brief Get the `LOG_ARG_` code of an argument type, after promotion.
+ *
+ * @returns The code.
+ */
+template <typename T>
+constexpr char log_arg_type(void) {
+
+    // Enums are coded as their underlying integer type
+    using Integer = typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::common_type<T>>::type::type;
+    return std::is_floating_point<T>::value ? LOG_ARG_DOUBLE
+         : (std::is_same<T, char*>::value || std::is_same<T, const char*>::value) ? LOG_ARG_STRING
+         : !std::is_integral<Integer>::value ? LOG_ARG_POINTER
+         : sizeof(Integer) < sizeof(int) ? LOG_ARG_INT
+         : sizeof(Integer) > sizeof(int) ? (std::is_signed<Integer>::value ? LOG_ARG_INT64 : LOG_ARG_UINT64)
+         : (std::is_signed<Integer>::value ? LOG_ARG_INT : LOG_ARG_UINT);
 }
 #endif
+#endif
 
 
 #endif /* LOGGING_H */
@@ -73,7 +73,7 @@ static void setupGPIO(void) {
 static void setupI2C(void) {
 
     // Initialize the I2C bus for the display and sensor
-    I2C::setup((uint8_t)HT16K33_Segment::DATA::ADDRESS);
+    I2C::setup();
 }
 
 
@@ -90,6 +90,7 @@ static inline void setDefaults(Prefs& settings) {
     settings.flash = true;
     settings.led = false;
     settings.brightness = 15;
+    settings.tz[0] = 0;
 }
 
 
@@ -100,8 +101,8 @@ static void logDeviceInfo(void) {
 
     uint8_t buffer[35] = { 0 };
     mvGetDeviceId(buffer, 34);
-    server_log("Device: %s", buffer);
-    server_log("   App: %s %s-%u", APP_NAME, APP_VERSION, BUILD_NUM);
+    LOG_DEBUG(APP, "Device: %s", buffer);
+    LOG_DEBUG(APP, "   App: %s %s-%u", APP_NAME, APP_VERSION, BUILD_NUM);
 }
 
 
@@ -111,47 +112,55 @@ static void logDeviceInfo(void) {
 
 int main() {
 
+    Boot::mark(BOOT_PHASE::START);
+
     // Reset of all peripherals, initializes the Flash interface and the Systick.
     HAL_Init();
 
     // Configure the system clock
     system_clock_config();
+    profile_init();
+    Boot::mark(BOOT_PHASE::HAL_READY);
 
     // Set up the hardware
     setupGPIO();
     setupI2C();
+    Boot::mark(BOOT_PHASE::I2C_READY);
 
-    // Instantiate the display driver
-    auto display = HT16K33_Segment();
-    display.init();
-
-    // Create a preferencs store and
-    // set the defaults
+    // Create a preferencs store and set the defaults, then apply
+    // the settings saved last time, if there are any, so the
+    // clock shows them before the network is up
     Prefs prefs;
     setDefaults(prefs);
+    Store::load(prefs);
+    Boot::mark(BOOT_PHASE::PREFS_LOADED);
 
-    // Display SYNC while we wait for the RTC to be set
-    constexpr uint8_t SYNC_TEXT[4] = {0x6D, 0x6E, 0x37, 0x39};
+    // Find the display panels, then display SYNC
+    // on them until the RTC is set
+    auto display = DisplayGroup();
     display.init(prefs.brightness);
-    for (uint32_t i = 0 ; i < 4 ; ++i) display.setGlyph(SYNC_TEXT[i], i, false);
+    for (uint32_t p = 0 ; p < display.size() ; ++p) display.panel(p).setText("SYNC");
     display.draw();
+    Boot::mark(BOOT_PHASE::DISPLAY_READY);
 
-    // Open the network
+    // Request the network. This doesn't wait for the connection:
+    // the clock runs from the RTC while the network, logging and
+    // config come up in the background
     // NOTE Do this before calling `log_device_info()`
     Config::Network::open();
+    Boot::mark(BOOT_PHASE::NETWORK_REQUESTED);
 
     // Get the Device ID and build number
     logDeviceInfo();
 
-    // Load in the clock settings
-    const bool gotPrefs = Config::getPrefs(prefs);
-    if (gotPrefs) {
-        server_log("Clock settings received");
-    } else {
-        server_error("Clock settings not yet received");
-    }
+    // Start loading in the clock settings. The clock
+    // applies them when they arrive
+    Config::requestPrefs();
 
-    // Instantiate a Clock object and run it
-    auto mvclock = Clock(prefs, display, gotPrefs);
+    // Instantiate a Clock object and run it. Start-up
+    // is complete: from here on, nothing should use the heap
+    auto mvclock = Clock(prefs, display);
+    Heap::markBooted();
+    Boot::mark(BOOT_PHASE::LOOP_STARTED);
     mvclock.loop();
 }
@@ -21,11 +21,23 @@
 #include "stm32u5xx_hal.h"
 #include "mv_syscalls.h"
 // App
+#include "civil_time.h"
+#include "dst.h"
 #include "i2c.h"
+#include "ht16k33_layouts.h"
 #include "ht16k33.h"
+#include "display_group.h"
+#include "scroller.h"
+#include "animation.h"
 #include "clock.h"
+#include "store.h"
 #include "config.h"
+#include "notifications.h"
+#include "idle.h"
+#include "heap.h"
+#include "boot.h"
 #include "logging.h"
+#include "profile.h"
 #include "uart_logging.h"
 #include <ArduinoJson.h>
 
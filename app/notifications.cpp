@@ -0,0 +1,225 @@
+/*
+ * Microvisor Clock Demo -- Notifications namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * FORWARD DECLARATIONS
+ */
+#ifdef __cplusplus
+extern "C" void TIM8_BRK_IRQHandler(void);
+#endif
+
+
+/*
+ * TYPES
+ */
+typedef void (*Handler)(const MvNotification& notification);
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void ignore(const MvNotification& notification);
+
+
+/*
+ * CONSTANTS
+ */
+// Records in Microvisor's notification center. Each record is 16 bytes in size
+constexpr uint32_t      CENTER_SIZE_R = 16;
+// Records in the ISR-to-main-loop queue. Must be a power of two
+constexpr uint32_t      QUEUE_SIZE_R = 32;
+static_assert((QUEUE_SIZE_R & (QUEUE_SIZE_R - 1)) == 0, "Queue size must be a power of two");
+
+// Notification handlers, indexed by USER_TAG
+static constexpr Handler HANDLERS[] = {
+    nullptr,                                // 0: unused
+    Config::Network::onNotification,        // USER_TAG::LOGGING_REQUEST_NETWORK
+    ignore,                                 // USER_TAG::LOGGING_OPEN_CHANNEL
+    ignore,                                 // USER_TAG::HTTP_OPEN_CHANNEL
+    Config::onNotification                  // USER_TAG::CONFIG_OPEN_CHANNEL
+};
+
+static_assert(sizeof(HANDLERS) / sizeof(Handler) == (uint32_t)USER_TAG::CONFIG_OPEN_CHANNEL + 1, "Every USER_TAG needs a HANDLERS entry");
+
+
+/*
+ * GLOBALS
+ */
+// Central store for notification records, written by Microvisor
+static          MvNotification          notificationCenter[CENTER_SIZE_R] __attribute__((aligned(8)));
+static          uint32_t                centerIndex = 0;
+static          MvNotificationHandle    handle = nullptr;
+
+// Single-producer (ISR), single-consumer (main loop) queue
+static          MvNotification          queue[QUEUE_SIZE_R];
+static volatile uint32_t                queueHead = 0;
+static volatile uint32_t                queueTail = 0;
+
+static volatile uint32_t                published = 0;
+static volatile uint32_t                overruns = 0;
+static          NotificationStats       stats = { 0, 0, 0, 0, 0, 0 };
+
+
+namespace Notifications {
+
+/**
+ * @brief Configure the Notification Center.
+ *
+ * @returns `true` if the center is ready, otherwise `false`.
+ */
+bool setup(void) {
+
+    if (handle == nullptr) {
+        // Clear the notification store
+        memset((void *)notificationCenter, 0xff, sizeof(notificationCenter));
+
+        static struct MvNotificationSetup notificationConfig = {
+            .irq = TIM8_BRK_IRQn,
+            .buffer = (struct MvNotification *)notificationCenter,
+            .buffer_size = sizeof(notificationCenter)
+        };
+
+        // Ask Microvisor to establish the notification center
+        // and confirm that it has accepted the request
+        enum MvStatus status = mvSetupNotifications(&notificationConfig, &handle);
+        if (status == MV_STATUS_OKAY) {
+            // Start the notification IRQ
+            NVIC_ClearPendingIRQ(TIM8_BRK_IRQn);
+            NVIC_EnableIRQ(TIM8_BRK_IRQn);
+        } else {
+            handle = nullptr;
+            return false;
+        }
+
+        LOG_DEBUG(APP, "Notification Center handle: %lu", handle);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Get the Notification Center handle for use in
+ *        network and channel requests.
+ *
+ * @returns The handle, or `nullptr` if `setup()` hasn't succeeded.
+ */
+MvNotificationHandle getHandle(void) {
+
+    return handle;
+}
+
+
+/**
+ * @brief Pass every queued notification to its handler.
+ *
+ * Call from the main loop, never from an ISR.
+ *
+ * @returns The number of notifications handled.
+ */
+uint32_t dispatch(void) {
+
+    uint32_t count = 0;
+    uint64_t now = 0;
+
+    while (queueTail != queueHead) {
+        // Read the slot only after seeing the ISR publish it
+        __DMB();
+        const MvNotification& notification = queue[queueTail & (QUEUE_SIZE_R - 1)];
+
+        const Handler handler = notification.tag < sizeof(HANDLERS) / sizeof(Handler) ? HANDLERS[notification.tag] : nullptr;
+        if (handler != nullptr) {
+            handler(notification);
+        } else {
+            stats.unknownTags++;
+        }
+
+        if (now == 0) mvGetMicroseconds(&now);
+        if (now > notification.microseconds) {
+            stats.lastLatencyUs = (uint32_t)(now - notification.microseconds);
+            if (stats.lastLatencyUs > stats.maxLatencyUs) stats.maxLatencyUs = stats.lastLatencyUs;
+        }
+
+        // Free the slot only once we're done with it
+        __DMB();
+        queueTail = queueTail + 1;
+        count++;
+    }
+
+    stats.dispatched += count;
+    return count;
+}
+
+
+/**
+ * @brief Get the notification counters.
+ *
+ * @returns The notification statistics.
+ */
+NotificationStats getStats(void) {
+
+    stats.published = published;
+    stats.overruns = overruns;
+    return stats;
+}
+
+
+}   // namespace Notifications
+
+
+/**
+ * @brief Handle a notification that needs no action, such as
+ *        the logging and HTTP channels' notices.
+ *
+ * @param notification: The notification.
+ */
+static void ignore(const MvNotification& notification) {
+
+    (void)notification;
+}
+
+
+/**
+ * @brief The shared channel notification interrupt handler.
+ *
+ * This is called by Microvisor. It copies every new record into
+ * the queue for the main loop to handle, and wakes the main loop.
+ * Do NOT make Microvisor System Calls in the ISR!
+ */
+void TIM8_BRK_IRQHandler(void) {
+
+    while (true) {
+        volatile MvNotification& record = notificationCenter[centerIndex];
+        const auto eventType = (uint32_t)record.event_type;
+        if (eventType == 0 || eventType == 0xFFFFFFFF) break;
+
+        if (queueHead - queueTail < QUEUE_SIZE_R) {
+            MvNotification& slot = queue[queueHead & (QUEUE_SIZE_R - 1)];
+            slot.microseconds = record.microseconds;
+            slot.event_type = record.event_type;
+            slot.tag = record.tag;
+
+            // Publish the slot only once it is filled
+            __DMB();
+            queueHead = queueHead + 1;
+            published = published + 1;
+        } else {
+            overruns = overruns + 1;
+        }
+
+        // Clear the record and point to the next one to be written
+        // See https://www.twilio.com/docs/iot/microvisor/microvisor-notifications#buffer-overruns
+        record.event_type = (MvEventType)0;
+        centerIndex = (centerIndex + 1) % CENTER_SIZE_R;
+    }
+
+    Idle::wake();
+}
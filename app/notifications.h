@@ -0,0 +1,38 @@
+/*
+ * Microvisor Clock Demo -- Notifications namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _NOTIFICATIONS_HEADER_
+#define _NOTIFICATIONS_HEADER_
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    published;      // Records passed from the ISR to the main loop
+    uint32_t    dispatched;     // Records handled in the main loop
+    uint32_t    overruns;       // Records dropped because the queue was full
+    uint32_t    unknownTags;    // Records with no registered handler
+    uint32_t    lastLatencyUs;  // Event-to-dispatch time of the last record
+    uint32_t    maxLatencyUs;
+} NotificationStats;
+
+
+/*
+ * PROTOTYPES
+ */
+namespace Notifications {
+
+    bool                    setup(void);
+    MvNotificationHandle    getHandle(void);
+    uint32_t                dispatch(void);
+    NotificationStats       getStats(void);
+}
+
+
+#endif  // _NOTIFICATIONS_HEADER_
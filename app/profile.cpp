@@ -0,0 +1,130 @@
+/*
+ * Microvisor Clock Demo -- cycle-count profiler
+ *
+ * Counts the CPU cycles spent in each profiled zone, using the
+ * Cortex-M33's DWT cycle counter, and logs a summary of each zone
+ * periodically. Built only when PROFILE_ENABLED is true.
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+#if PROFILE_ENABLED
+
+/*
+ * GLOBALS
+ */
+static          ProfileStats    stats[PROFILE_ZONE_COUNT];
+static          bool            running = false;
+static          uint32_t        lastReportTick = 0;
+
+static const    char* const     ZONE_NAMES[PROFILE_ZONE_COUNT] = {
+    "tick", "config", "time fetch", "dst", "render", "draw", "animate", "i2c write", "log post"
+};
+
+
+/**
+ * @brief Clear the zone statistics.
+ */
+static void resetStats(void) {
+
+    for (uint32_t i = 0 ; i < PROFILE_ZONE_COUNT ; ++i) {
+        stats[i] = { 0, UINT32_MAX, 0, 0 };
+    }
+}
+
+
+/**
+ * @brief Start the cycle counter.
+ */
+void profile_init(void) {
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // The counter may be withheld from the non-secure app
+    const uint32_t start = profile_cycles();
+    for (volatile uint32_t i = 0 ; i < 16 ; ++i) {}
+    running = (profile_cycles() != start);
+    if (!running) LOG_ERROR(APP, "Profiler: DWT cycle counter unavailable");
+
+    resetStats();
+    lastReportTick = HAL_GetTick();
+}
+
+
+/**
+ * @brief Add a run of a zone to its statistics.
+ *
+ * @param zone:         The zone.
+ * @param start_cycles: The cycle count when the zone was entered.
+ */
+void profile_record(ProfileZone zone, uint32_t start_cycles) {
+
+    // Unsigned subtraction copes with the counter wrapping
+    const uint32_t cycles = profile_cycles() - start_cycles;
+    if (!running) return;
+
+    // Zones are also recorded in interrupt context
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ProfileStats& zoneStats = stats[zone];
+    zoneStats.count++;
+    zoneStats.totalCycles += cycles;
+    if (cycles < zoneStats.minCycles) zoneStats.minCycles = cycles;
+    if (cycles > zoneStats.maxCycles) zoneStats.maxCycles = cycles;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Log a summary of every zone run since the last
+ *        summary, once the report period has passed.
+ *
+ * Call this regularly from the main loop.
+ */
+void profile_report(void) {
+
+    const uint32_t now = HAL_GetTick();
+    if (!running || now - lastReportTick < PROFILE_REPORT_PERIOD_S * 1000) return;
+    lastReportTick = now;
+
+    // Take the figures first: logging them is itself profiled
+    ProfileStats snapshot[PROFILE_ZONE_COUNT];
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(snapshot, stats, sizeof(snapshot));
+    resetStats();
+    __set_PRIMASK(primask);
+
+    for (uint32_t i = 0 ; i < PROFILE_ZONE_COUNT ; ++i) {
+        const ProfileStats& zoneStats = snapshot[i];
+        if (zoneStats.count == 0) continue;
+        LOG_DEBUG(APP, "Profile %s: %lu runs, cycles min %lu, avg %lu, max %lu", ZONE_NAMES[i], zoneStats.count,
+                  zoneStats.minCycles, (uint32_t)(zoneStats.totalCycles / zoneStats.count), zoneStats.maxCycles);
+    }
+}
+
+
+/**
+ * @brief Get a zone's statistics since the last summary.
+ *
+ * @param zone: The zone.
+ *
+ * @returns The statistics.
+ */
+ProfileStats profile_get_stats(ProfileZone zone) {
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const ProfileStats zoneStats = stats[zone];
+    __set_PRIMASK(primask);
+    return zoneStats;
+}
+
+#endif  // PROFILE_ENABLED
@@ -0,0 +1,147 @@
+/*
+ * Microvisor Clock Demo -- cycle-count profiler
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32u5xx_hal.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Set to true, in the top-level `CMakeLists.txt`, to build the profiler
+// in. When false, the markers below compile to nothing
+#ifndef PROFILE_ENABLED
+#define     PROFILE_ENABLED                     false
+#endif
+
+// How often the zone summary is logged
+#ifndef PROFILE_REPORT_PERIOD_S
+#define     PROFILE_REPORT_PERIOD_S             60
+#endif
+
+
+/*
+ * ENUMERATIONS
+ */
+// Profiled code. Zones may nest: a zone's cycles include
+// those of any zones entered within it
+typedef enum {
+    PROFILE_ZONE_TICK = 0,          // One pass of the clock
+    PROFILE_ZONE_CONFIG,            // Network and config servicing
+    PROFILE_ZONE_TIME_FETCH,        // Reading the RTC
+    PROFILE_ZONE_DST,               // UTC offset lookup
+    PROFILE_ZONE_RENDER,            // Setting the display buffer
+    PROFILE_ZONE_DRAW,              // Sending the display buffer
+    PROFILE_ZONE_ANIMATE,           // Rendering an animation frame
+    PROFILE_ZONE_I2C_WRITE,         // Queueing an I2C write
+    PROFILE_ZONE_LOG_POST,          // Formatting and posting a log message
+    PROFILE_ZONE_COUNT
+} ProfileZone;
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    count;              // Times the zone was run
+    uint32_t    minCycles;
+    uint32_t    maxCycles;
+    uint64_t    totalCycles;
+} ProfileStats;
+
+
+#if PROFILE_ENABLED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void            profile_init(void);
+void            profile_record(ProfileZone zone, uint32_t start_cycles);
+void            profile_report(void);
+ProfileStats    profile_get_stats(ProfileZone zone);
+
+
+/**
+ * @brief Read the Cortex-M33 cycle counter.
+ *
+ * @returns The cycle count.
+ */
+static inline uint32_t profile_cycles(void) {
+
+    return DWT->CYCCNT;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+/*
+ * MARKERS
+ *
+ * Time a block between `PROFILE_BEGIN(zone)` and `PROFILE_END(zone)`,
+ * or, in C++, from `PROFILE_SCOPE(zone)` to the end of the scope.
+ */
+#define PROFILE_BEGIN(zone)         const uint32_t profile_start_##zone = profile_cycles()
+#define PROFILE_END(zone)           profile_record(zone, profile_start_##zone)
+
+#ifdef __cplusplus
+#define PROFILE_SCOPE(zone)         ProfileScope PROFILE_NAME(profile_scope_, __LINE__)(zone)
+#define PROFILE_NAME(prefix, line)  PROFILE_PASTE(prefix, line)
+#define PROFILE_PASTE(prefix, line) prefix##line
+
+/**
+    Records the cycles from its construction to its destruction.
+ */
+class ProfileScope {
+
+    public:
+        explicit ProfileScope(ProfileZone inZone)
+            :zone(inZone),
+             start(profile_cycles())
+        {}
+
+        ~ProfileScope() {
+            profile_record(zone, start);
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        ProfileZone     zone;
+        uint32_t        start;
+};
+#endif
+
+#else
+
+#define profile_init()              do {} while (0)
+#define profile_report()            do {} while (0)
+#define PROFILE_BEGIN(zone)         do {} while (0)
+#define PROFILE_END(zone)           do {} while (0)
+#define PROFILE_SCOPE(zone)         do {} while (0)
+
+#endif  // PROFILE_ENABLED
+
+
+#endif  // PROFILE_H
@@ -0,0 +1,83 @@
+/*
+ * Microvisor Clock Demo -- Text scroller
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/**
+ * @brief Scroll a string across a display.
+ *
+ * @param inText: The string, which is not copied. Default: empty.
+ */
+TextScroller::TextScroller(const char* inText) {
+
+    start(inText);
+}
+
+
+/**
+ * @brief Begin scrolling a string, from a blank display.
+ *
+ * A '.' lights the decimal point of the character before it,
+ * rather than taking a step of its own.
+ *
+ * @param inText: The string, which is not copied, so must remain
+ *                valid until the scroll is done.
+ */
+void TextScroller::start(const char* inText) {
+
+    next = (inText != nullptr) ? inText : "";
+    memset(window, 0x00, sizeof(window));
+    blanksLeft = sizeof(window);
+}
+
+
+/**
+ * @brief Move the text one digit to the left.
+ *
+ * @returns `true` if the text moved, or `false` if it
+ *          has already left the display.
+ */
+bool TextScroller::step(void) {
+
+    if (isDone()) return false;
+
+    // Once the string is in, blanks follow it on
+    const bool isTextIn = (*next == 0);
+    if (isTextIn) blanksLeft--;
+
+    window[0] = window[1];
+    window[1] = window[2];
+    window[2] = window[3];
+    window[3] = HT16K33_Segment::nextGlyph(next);
+    return true;
+}
+
+
+/**
+ * @brief Has the text scrolled completely off the display?
+ *
+ * @returns `true` if the scroll is done, otherwise `false`.
+ */
+bool TextScroller::isDone(void) const {
+
+    return (*next == 0 && blanksLeft == 0);
+}
+
+
+/**
+ * @brief Put the visible glyphs into a display's buffer.
+ *
+ * The colon is left as it is, and the display is not drawn.
+ *
+ * @param panel: The display.
+ */
+void TextScroller::render(HT16K33_Segment& panel) const {
+
+    for (uint32_t i = 0 ; i < sizeof(window) ; ++i) panel.setGlyph(window[i], i, false);
+}
@@ -0,0 +1,38 @@
+/*
+ * Microvisor Clock Demo -- Text scroller
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _SCROLLER_HEADER_
+#define _SCROLLER_HEADER_
+
+
+/**
+    Scrolls a string of any length right to left across a four-digit
+    display. The string enters from the right and leaves to the left.
+    Each step shifts the four visible glyphs along by one and looks up
+    the glyph of just the one character that enters.
+ */
+class TextScroller {
+
+    public:
+        // Constructor
+        explicit            TextScroller(const char* inText = "");
+        // Methods
+        void                start(const char* inText);
+        bool                step(void);
+        bool                isDone(void) const;
+        void                render(HT16K33_Segment& panel) const;
+
+    private:
+        // Properties
+        const char*         next;               // The next character to enter. Not copied: must remain valid
+        uint8_t             window[4] = {0};    // The glyphs shown, L-R
+        uint32_t            blanksLeft = 0;     // Steps left, once the string has entered, to clear the display
+};
+
+
+#endif  // _SCROLLER_HEADER_
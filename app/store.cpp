@@ -0,0 +1,289 @@
+/*
+ * Microvisor Clock Demo -- Store namespace
+ *
+ * Keeps the clock's prefs in a pair of internal flash pages, as a
+ * log of CRC-checked records. Each save appends a record to the
+ * active page. When that page is full, the other page is erased and
+ * becomes the active page, so erases alternate between the two, and
+ * the newest record survives an interrupted erase or write. At boot,
+ * the newest intact record is the one loaded.
+ *
+ * The pages are reserved outside the app's image by store.ld, so the
+ * prefs survive re-flashing and updates.
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t  PAGE_COUNT = 2;
+constexpr uint32_t  NO_PAGE = PAGE_COUNT;
+// Records fill whole quad-words, the unit of flash programming
+constexpr uint32_t  QUAD_WORD_B = 16;
+constexpr uint32_t  SLOT_SIZE_B = (sizeof(PrefsRecord) + QUAD_WORD_B - 1) & ~(QUAD_WORD_B - 1);
+constexpr uint32_t  SLOTS_PER_PAGE = FLASH_PAGE_SIZE / SLOT_SIZE_B;
+
+
+/*
+ * GLOBALS
+ */
+static          bool        scanned = false;
+static          uint32_t    activePage = NO_PAGE;
+static          uint32_t    newestSlot = 0;
+static          uint32_t    newestSequence = 0;
+static          uint32_t    nextSlot[PAGE_COUNT] = { SLOTS_PER_PAGE, SLOTS_PER_PAGE };
+
+// The record being written. Not on the stack, as the HAL
+// takes its address as a 32-bit value
+static          uint8_t     slotBuffer[SLOT_SIZE_B] __attribute__((aligned(4)));
+
+
+// The store's flash pages, placed by store.ld. On a new device they may
+// hold anything; slots that are neither erased nor valid are skipped,
+// and a full page is erased before it is reused
+extern "C" uint8_t __prefs_store_start[];
+
+
+namespace Store {
+
+/**
+ * @brief Get the address of a record slot.
+ *
+ * @param page: The page index.
+ * @param slot: The slot index within the page.
+ *
+ * @returns A pointer to the slot.
+ */
+static const uint8_t* slotAddress(uint32_t page, uint32_t slot) {
+
+    return __prefs_store_start + page * FLASH_PAGE_SIZE + slot * SLOT_SIZE_B;
+}
+
+
+/**
+ * @brief Calculate the CRC-32 of a block of data.
+ *
+ * @param data:   The data.
+ * @param length: Its length in bytes.
+ *
+ * @returns The CRC.
+ */
+static uint32_t crc32(const uint8_t* data, uint32_t length) {
+
+    // A nibble at a time, to keep the table small
+    static constexpr uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        crc = TABLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+
+/**
+ * @brief Check whether a block of flash is erased.
+ *
+ * @param data:   The block.
+ * @param length: Its length in bytes.
+ *
+ * @returns `true` if the block is erased, otherwise `false`.
+ */
+static bool isErased(const uint8_t* data, uint32_t length) {
+
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        if (data[i] != 0xFF) return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Read a record slot.
+ *
+ * @param slot:   The slot.
+ * @param record: Receives the slot's contents.
+ *
+ * @returns `true` if the slot holds an intact record, otherwise `false`.
+ */
+static bool readRecord(const uint8_t* slot, PrefsRecord& record) {
+
+    memcpy(&record, slot, sizeof(PrefsRecord));
+    return record.magic == PREFS_RECORD_MAGIC
+        && record.crc == crc32((const uint8_t*)&record, offsetof(PrefsRecord, crc));
+}
+
+
+/**
+ * @brief Find each page's first free slot, and the newest record.
+ */
+static void scan(void) {
+
+    PrefsRecord record;
+    activePage = NO_PAGE;
+
+    for (uint32_t page = 0 ; page < PAGE_COUNT ; ++page) {
+        // Records are written in order, starting with their first
+        // quad-word, so the first erased one ends the page's log
+        uint32_t slot = 0;
+        while (slot < SLOTS_PER_PAGE && !isErased(slotAddress(page, slot), QUAD_WORD_B)) ++slot;
+        nextSlot[page] = slot;
+
+        // Work back to the page's newest intact record
+        while (slot > 0) {
+            --slot;
+            if (readRecord(slotAddress(page, slot), record)) {
+                if (activePage == NO_PAGE || record.sequence > newestSequence) {
+                    activePage = page;
+                    newestSlot = slot;
+                    newestSequence = record.sequence;
+                }
+
+                break;
+            }
+        }
+    }
+
+    scanned = true;
+}
+
+
+/**
+ * @brief Erase one of the store's pages.
+ *
+ * @param page: The page index.
+ *
+ * @returns `true` if the page was erased, otherwise `false`.
+ */
+static bool erase(uint32_t page) {
+
+    const uint32_t offset = (uint32_t)(uintptr_t)slotAddress(page, 0) - FLASH_BASE;
+
+    FLASH_EraseInitTypeDef request;
+    request.TypeErase = FLASH_TYPEERASE_PAGES;
+    request.Banks = offset < FLASH_BANK_SIZE ? FLASH_BANK_1 : FLASH_BANK_2;
+    request.Page = (offset % FLASH_BANK_SIZE) / FLASH_PAGE_SIZE;
+    request.NbPages = 1;
+
+    uint32_t pageError = 0;
+    HAL_FLASH_Unlock();
+    const HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&request, &pageError);
+    HAL_FLASH_Lock();
+
+    if (status != HAL_OK) {
+        LOG_ERROR(STORE, "Could not erase flash page %lu (status: %i)", request.Page, status);
+        return false;
+    }
+
+    nextSlot[page] = 0;
+    return true;
+}
+
+
+/**
+ * @brief Write `slotBuffer` to a free record slot.
+ *
+ * @param page: The page index.
+ * @param slot: The slot index within the page.
+ *
+ * @returns `true` if the record was written, otherwise `false`.
+ */
+static bool program(uint32_t page, uint32_t slot) {
+
+    const auto address = (uint32_t)(uintptr_t)slotAddress(page, slot);
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t offset = 0 ; offset < SLOT_SIZE_B && status == HAL_OK ; offset += QUAD_WORD_B) {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_QUADWORD, address + offset, (uint32_t)(uintptr_t)&slotBuffer[offset]);
+    }
+    HAL_FLASH_Lock();
+
+    if (status != HAL_OK) {
+        LOG_ERROR(STORE, "Could not write flash at 0x%08lx (status: %i)", address, status);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Load the most recently saved prefs.
+ *
+ * @param prefs: Reference to the app's preferences data. Left
+ *               unchanged if no prefs have been saved.
+ *
+ * @returns `true` if `prefs` was loaded, otherwise `false`.
+ */
+bool load(Prefs& prefs) {
+
+    scan();
+    if (activePage == NO_PAGE) return false;
+
+    PrefsRecord record;
+    if (!readRecord(slotAddress(activePage, newestSlot), record)) return false;
+    memcpy(&prefs, &record.prefs, sizeof(Prefs));
+    return true;
+}
+
+
+/**
+ * @brief Append prefs to the store.
+ *
+ * @param prefs: Reference to the app's preferences data.
+ *
+ * @returns `true` if `prefs` was saved, otherwise `false`.
+ */
+bool save(const Prefs& prefs) {
+
+    if (!scanned) scan();
+
+    // Skip any slot left part-written, eg. by a power loss,
+    // then move to the other page if this one is full
+    uint32_t page = activePage == NO_PAGE ? 0 : activePage;
+    while (nextSlot[page] < SLOTS_PER_PAGE && !isErased(slotAddress(page, nextSlot[page]), SLOT_SIZE_B)) nextSlot[page]++;
+    if (nextSlot[page] == SLOTS_PER_PAGE) {
+        if (activePage != NO_PAGE) page = (page + 1) % PAGE_COUNT;
+        if (!erase(page)) return false;
+    }
+
+    // Build the record. Clear it first, so its padding is
+    // consistent for the CRC
+    PrefsRecord record;
+    memset(&record, 0, sizeof(PrefsRecord));
+    record.magic = PREFS_RECORD_MAGIC;
+    record.sequence = newestSequence + 1;
+    memcpy(&record.prefs, &prefs, sizeof(Prefs));
+    record.crc = crc32((const uint8_t*)&record, offsetof(PrefsRecord, crc));
+
+    memset(slotBuffer, 0xFF, sizeof(slotBuffer));
+    memcpy(slotBuffer, &record, sizeof(PrefsRecord));
+
+    const uint32_t slot = nextSlot[page]++;
+    if (!program(page, slot) || !readRecord(slotAddress(page, slot), record)) {
+        LOG_ERROR(STORE, "Could not save settings");
+        return false;
+    }
+
+    activePage = page;
+    newestSlot = slot;
+    newestSequence = record.sequence;
+    LOG_DEBUG(STORE, "Settings saved (record %lu)", newestSequence);
+    return true;
+}
+
+
+}   // namespace Store
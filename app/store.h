@@ -0,0 +1,41 @@
+/*
+ * Microvisor Clock Demo -- Store namespace
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _STORE_HEADER_
+#define _STORE_HEADER_
+
+
+/*
+ * CONSTANTS
+ */
+// Change the version byte whenever the layout of `Prefs` changes
+constexpr uint32_t  PREFS_RECORD_MAGIC = 0x50524601;    // "PRF", version 1
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    magic;          // PREFS_RECORD_MAGIC
+    uint32_t    sequence;       // Increases with each record written
+    Prefs       prefs;
+    uint32_t    crc;            // CRC-32 of the fields above
+} PrefsRecord;
+
+
+/*
+ * PROTOTYPES
+ */
+namespace Store {
+
+    bool        load(Prefs& prefs);
+    bool        save(const Prefs& prefs);
+}
+
+
+#endif  // _STORE_HEADER_
@@ -10,6 +10,28 @@
 
 
 static UART_HandleTypeDef log_uart;
+static DMA_HandleTypeDef  log_dma;
+
+// Transmit ring buffer. The indices run freely and are masked on
+// use, so `ring_head - ring_tail` is always the number of bytes queued
+static uint8_t            ring[UART_LOG_RING_SIZE_B];
+static volatile uint32_t  ring_head = 0;
+static volatile uint32_t  ring_tail = 0;
+static volatile uint32_t  dma_length = 0;
+static volatile uint32_t  dropped_bytes = 0;
+
+// The "YYYY-MM-DD HH:MM:SS" prefix, formatted once per second
+static char               prefix[CIVIL_TIMESTAMP_LEN];
+static int64_t            prefix_second = -1;
+
+static_assert((UART_LOG_RING_SIZE_B & (UART_LOG_RING_SIZE_B - 1)) == 0, "UART log ring size must be a power of two");
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void ring_write(const char* source, uint32_t length);
+static void ring_send(void);
 
 
 /**
@@ -27,11 +49,11 @@ bool log_uart_init(void) {
 
     // Initialize the UART
     if (HAL_UART_Init(&log_uart) != HAL_OK) {
-      server_error("Could not enable logging UART");
+      LOG_ERROR(APP, "Could not enable logging UART");
       return false;
     }
 
-    server_log("UART logging enabled");
+    LOG_DEBUG(APP, "UART logging enabled");
     return true;
 }
 
@@ -51,7 +73,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef *uart) {
 
     // Initialize U5 peripheral clock
     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK) {
-        server_error("Could not enable logging UART clock");
+        LOG_ERROR(APP, "Could not enable logging UART clock");
         return;
     }
 
@@ -73,49 +95,184 @@ void HAL_UART_MspInit(UART_HandleTypeDef *uart) {
 
     // Enable the UART clock
     __HAL_RCC_USART2_CLK_ENABLE();
+
+    // Configure a GPDMA channel to feed the UART from the ring buffer
+    __HAL_RCC_GPDMA1_CLK_ENABLE();
+    log_dma.Instance                   = GPDMA1_Channel0;
+    log_dma.Init.Request               = GPDMA1_REQUEST_USART2_TX;
+    log_dma.Init.BlkHWRequest          = DMA_BREQ_SINGLE_BURST;
+    log_dma.Init.Direction             = DMA_MEMORY_TO_PERIPH;
+    log_dma.Init.SrcInc                = DMA_SINC_INCREMENTED;
+    log_dma.Init.DestInc               = DMA_DINC_FIXED;
+    log_dma.Init.SrcDataWidth          = DMA_SRC_DATAWIDTH_BYTE;
+    log_dma.Init.DestDataWidth         = DMA_DEST_DATAWIDTH_BYTE;
+    log_dma.Init.Priority              = DMA_LOW_PRIORITY_LOW_WEIGHT;
+    log_dma.Init.SrcBurstLength        = 1;
+    log_dma.Init.DestBurstLength       = 1;
+    log_dma.Init.TransferAllocatedPort = DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0;
+    log_dma.Init.TransferEventMode     = DMA_TCEM_BLOCK_TRANSFER;
+    log_dma.Init.Mode                  = DMA_NORMAL;
+    if (HAL_DMA_Init(&log_dma) != HAL_OK) {
+        LOG_ERROR(APP, "Could not enable logging UART DMA");
+        return;
+    }
+
+    __HAL_LINKDMA(uart, hdmatx, log_dma);
+
+    // The DMA interrupt signals the end of the block; the UART
+    // interrupt signals that the last byte has left the wire
+    HAL_NVIC_SetPriority(GPDMA1_Channel0_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(GPDMA1_Channel0_IRQn);
+    HAL_NVIC_SetPriority(USART2_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(USART2_IRQn);
 }
 
 
 /**
- * @brief Output a UART-friendly log string, ie. one with
- *        RETURN+NEWLINE in place of NEWLINE.
+ * @brief Queue a UART-friendly log string, ie. one with
+ *        RETURN+NEWLINE in place of NEWLINE, for sending by DMA.
+ *
+ * Messages which do not fit in the ring buffer are dropped whole,
+ * so the output never contains partial lines. Dropped bytes are
+ * counted: see `log_uart_get_dropped_bytes()`.
  *
  * @param buffer: Source string.
- * @param length: String character count.
  */
 void log_uart_output(const char* buffer) {
 
-    char uart_buffer[UART_LOG_TIMESTAMP_MAX_LEN_B + UART_LOG_MESSAGE_MAX_LEN_B + 3] = {0};
-
     uint64_t usec = 0;
-    time_t sec = 0;
-    time_t msec = 0;
-
     enum MvStatus status = mvGetWallTime(&usec);
-    if (status == MV_STATUS_OKAY) {
-        // Get the second and millisecond times
-        sec = (time_t)usec / 1000000;
-        msec = (time_t)usec / 1000;
+    if (status != MV_STATUS_OKAY) usec = 0;
+
+    // Count the bytes the translated message will need:
+    // the timestamp, the text, a RETURN per NEWLINE and the line end
+    const uint32_t length = (uint32_t)strnlen(buffer, UART_LOG_MESSAGE_MAX_LEN_B);
+    uint32_t needed = UART_LOG_TIMESTAMP_LEN_B + length + 2;
+    for (const char* nl = memchr(buffer, '\n', length) ; nl != NULL ; nl = memchr(nl + 1, '\n', length - (nl + 1 - buffer))) {
+        needed++;
+    }
+
+    // Build the timestamp as "2022-05-10 13:30:58.XXX ",
+    // re-formatting the date and time only when the second changes
+    char timestamp[UART_LOG_TIMESTAMP_LEN_B];
+    const int64_t second = (int64_t)(usec / 1000000);
+    const uint32_t msec = (uint32_t)((usec / 1000) % 1000);
+    if (second != prefix_second) {
+        const CivilTime now = civil_time_from_epoch(second);
+        civil_time_format(&now, prefix);
+        prefix_second = second;
     }
 
-    // Write time string as "2022-05-10 13:30:58.XXX "
-    strftime(uart_buffer, 64, "%F %T.XXX ", gmtime(&sec));
-    // Insert the millisecond time over the XXX
-    sprintf(&uart_buffer[20], "%03u ", (unsigned)(msec % 1000));
-    const uint32_t length = strlen(uart_buffer);
-
-    // Write the timestamp to the message
-    sprintf(&uart_buffer[length], "%s\n", buffer);
-
-    // Send uart_buffer to the UART
-    const char nls[2] = "\r\n";
-    char *buf_ptr = uart_buffer;
-    while(*buf_ptr != 0) {
-        if (*buf_ptr == '\n') {
-            HAL_UART_Transmit(&log_uart, (uint8_t*)nls, 2, 100);
-            buf_ptr++;
-        } else {
-            HAL_UART_Transmit(&log_uart, (uint8_t*)buf_ptr++, 1, 100);
-        }
+    memcpy(timestamp, prefix, CIVIL_TIMESTAMP_LEN);
+    timestamp[CIVIL_TIMESTAMP_LEN] = '.';
+    timestamp[CIVIL_TIMESTAMP_LEN + 1] = (char)('0' + msec / 100);
+    timestamp[CIVIL_TIMESTAMP_LEN + 2] = (char)('0' + (msec / 10) % 10);
+    timestamp[CIVIL_TIMESTAMP_LEN + 3] = (char)('0' + msec % 10);
+    timestamp[CIVIL_TIMESTAMP_LEN + 4] = ' ';
+
+    // Messages may be logged from interrupt handlers too
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (needed > UART_LOG_RING_SIZE_B - (ring_head - ring_tail)) {
+        dropped_bytes += needed;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    // Copy the message into the ring in runs between NEWLINEs
+    ring_write(timestamp, UART_LOG_TIMESTAMP_LEN_B);
+    const char* run = buffer;
+    const char* end = buffer + length;
+    for (const char* nl = memchr(run, '\n', length) ; nl != NULL ; nl = memchr(run, '\n', end - run)) {
+        ring_write(run, nl - run);
+        ring_write("\r\n", 2);
+        run = nl + 1;
+    }
+
+    ring_write(run, end - run);
+    ring_write("\r\n", 2);
+
+    // Start sending if the UART is idle
+    if (dma_length == 0) ring_send();
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Get the number of bytes discarded because the
+ *        UART could not keep up.
+ *
+ * @returns The dropped byte count.
+ */
+uint32_t log_uart_get_dropped_bytes(void) {
+
+    return dropped_bytes;
+}
+
+
+/**
+ * @brief Copy bytes into the ring buffer, wrapping as necessary.
+ *        The caller must have checked there is room.
+ *
+ * @param source: The bytes to copy.
+ * @param length: The number of bytes.
+ */
+static void ring_write(const char* source, uint32_t length) {
+
+    const uint32_t index = ring_head & (UART_LOG_RING_SIZE_B - 1);
+    const uint32_t first = length < UART_LOG_RING_SIZE_B - index ? length : UART_LOG_RING_SIZE_B - index;
+    memcpy(&ring[index], source, first);
+    memcpy(ring, source + first, length - first);
+    ring_head += length;
+}
+
+
+/**
+ * @brief Start a DMA transfer of the longest contiguous run
+ *        of queued bytes. Call with interrupts disabled, or
+ *        from the transfer-complete interrupt.
+ */
+static void ring_send(void) {
+
+    const uint32_t queued = ring_head - ring_tail;
+    if (queued == 0) return;
+
+    const uint32_t index = ring_tail & (UART_LOG_RING_SIZE_B - 1);
+    const uint32_t length = queued < UART_LOG_RING_SIZE_B - index ? queued : UART_LOG_RING_SIZE_B - index;
+    if (HAL_UART_Transmit_DMA(&log_uart, &ring[index], (uint16_t)length) == HAL_OK) {
+        dma_length = length;
     }
 }
+
+
+/**
+ * @brief HAL-called function on completion of a UART transmission.
+ *
+ * @param uart: A HAL UART_HandleTypeDef pointer to the UART instance.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *uart) {
+
+    if (uart != &log_uart) return;
+    ring_tail += dma_length;
+    dma_length = 0;
+    ring_send();
+}
+
+
+/**
+ * @brief Logging UART DMA channel interrupt handler.
+ */
+void GPDMA1_Channel0_IRQHandler(void) {
+
+    HAL_DMA_IRQHandler(&log_dma);
+}
+
+
+/**
+ * @brief Logging UART interrupt handler.
+ */
+void USART2_IRQHandler(void) {
+
+    HAL_UART_IRQHandler(&log_uart);
+}
@@ -27,12 +27,15 @@
 #include "mv_syscalls.h"
 // App
 #include "logging.h"
+#include "civil_time.h"
 
 /*
  * CONSTANTS
  */
-#define UART_LOG_TIMESTAMP_MAX_LEN_B        64
+#define UART_LOG_TIMESTAMP_LEN_B            (CIVIL_TIMESTAMP_LEN + 5)
 #define UART_LOG_MESSAGE_MAX_LEN_B          1024
+// Must be a power of two. About 180ms of output at 115200 baud
+#define UART_LOG_RING_SIZE_B                2048
 
 
 #ifdef __cplusplus
@@ -45,6 +48,7 @@ extern "C" {
  */
 bool    log_uart_init(void);
 void    log_uart_output(const char* buffer);
+uint32_t log_uart_get_dropped_bytes(void);
 
 
 #ifdef __cplusplus
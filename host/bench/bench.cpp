@@ -0,0 +1,387 @@
+/*
+ * Microvisor Clock Demo -- host micro-benchmarks
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Times the clock's per-tick paths on the host, against the simulated
+ * platform, and writes one JSON object per benchmark, per line:
+ *
+ *   {"benchmark": "clock.bcd", "iterations": 200000, "ns_per_op": 1.52, "instructions_per_op": 14.0, "allocations_per_op": 0.0}
+ *
+ * `instructions_per_op` comes from the CPU's retired-instruction
+ * counter, via perf_event_open(). It is `null` where the counter is
+ * unavailable, eg. in some VMs, or if perf_event_paranoid is above 2.
+ * `allocations_per_op` counts the app's heap allocations -- see heap.cpp.
+ *
+ * Each benchmark runs its operation in batches. Each batch is timed
+ * separately, less the cost of timing an empty batch, and the median
+ * batch is reported, which steadies the figures against interruptions.
+ *
+ */
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "ht16k33_emulator.h"
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t  BATCHES = 201;
+constexpr int64_t   BASE_TIME = 1719835200;     // 2024-07-01 12:00:00 UTC
+
+
+namespace Bench {
+
+/**
+ * @brief Stop the compiler optimising away a benchmarked result.
+ *
+ * @param value: The result.
+ */
+template<typename T>
+static inline void keep(const T& value) {
+
+    asm volatile("" : : "m"(value) : "memory");
+}
+
+
+/**
+ * @brief Read the monotonic clock.
+ *
+ * @returns The time in nanoseconds.
+ */
+static inline uint64_t nanoseconds(void) {
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+/**
+    Counts the user-space instructions retired by this thread.
+ */
+class InstructionCounter {
+
+    public:
+        InstructionCounter() {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        ~InstructionCounter() {
+            if (fd >= 0) close(fd);
+        }
+
+        bool available(void) const {
+            return fd >= 0;
+        }
+
+        uint64_t read(void) const {
+            uint64_t count = 0;
+            if (fd < 0 || ::read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+            return count;
+        }
+
+    private:
+        int fd = -1;
+};
+
+
+static InstructionCounter counter;
+
+
+/**
+ * @brief Get the median of a set of samples.
+ *
+ * @param samples: The samples. They are re-ordered.
+ *
+ * @returns The median.
+ */
+static double median(std::vector<double>& samples) {
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+/**
+ * @brief Time batches of an operation and report the per-operation
+ *        median. `reset` runs, untimed, before every batch.
+ *
+ * @param name:      The benchmark name.
+ * @param batchSize: Operations per batch.
+ * @param operation: Called with the running operation count.
+ * @param reset:     Restores the conditions the operation needs.
+ */
+template<typename Operation, typename Reset>
+static void run(const char* name, uint32_t batchSize, Operation operation, Reset reset) {
+
+    std::vector<double> times, instructions, emptyTimes, emptyInstructions;
+    uint32_t index = 0;
+    uint32_t allocations = 0;
+
+    // The first batch warms the caches and is not counted
+    for (uint32_t batch = 0 ; batch <= BATCHES ; ++batch) {
+        reset();
+        const uint32_t startAllocations = Heap::getStats().allocations;
+        uint64_t startTime = nanoseconds();
+        uint64_t startCount = counter.read();
+        for (uint32_t i = 0 ; i < batchSize ; ++i) operation(index++);
+        uint64_t endCount = counter.read();
+        uint64_t endTime = nanoseconds();
+        if (batch == 0) continue;
+        allocations += Heap::getStats().allocations - startAllocations;
+        times.push_back((double)(endTime - startTime));
+        instructions.push_back((double)(endCount - startCount));
+
+        // The cost of timing itself
+        startTime = nanoseconds();
+        startCount = counter.read();
+        endCount = counter.read();
+        endTime = nanoseconds();
+        emptyTimes.push_back((double)(endTime - startTime));
+        emptyInstructions.push_back((double)(endCount - startCount));
+    }
+
+    const double nsPerOp = std::max(0.0, median(times) - median(emptyTimes)) / batchSize;
+    const double instructionsPerOp = std::max(0.0, median(instructions) - median(emptyInstructions)) / batchSize;
+    printf("{\"benchmark\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.2f, \"instructions_per_op\": ",
+           name, BATCHES * batchSize, nsPerOp);
+    if (counter.available()) {
+        printf("%.1f", instructionsPerOp);
+    } else {
+        printf("null");
+    }
+
+    printf(", \"allocations_per_op\": %.1f}\n", (double)allocations / (BATCHES * batchSize));
+
+    fflush(stdout);
+}
+
+
+/**
+ * @brief Time batches of an operation that needs no reset.
+ *
+ * @param name:      The benchmark name.
+ * @param batchSize: Operations per batch.
+ * @param operation: Called with the running operation count.
+ */
+template<typename Operation>
+static void run(const char* name, uint32_t batchSize, Operation operation) {
+
+    run(name, batchSize, operation, [](){});
+}
+
+
+}   // namespace Bench
+
+
+/*
+ * RUNTIME START
+ */
+int main(void) {
+
+    // Run the platform silently, and for as long as the benchmarks need
+    Sim::Options options;
+    options.runSeconds = 30 * 24 * 3600;
+    options.startEpoch = BASE_TIME;
+    options.quiet = true;
+    options.silent = true;
+    Sim::configure(options);
+
+    // Eight panels: the clock drives the first, the group benchmarks all of them
+    static HT16K33_Emulator emulators[DisplayGroup::MAX_PANELS] = {
+        HT16K33_Emulator(0x70), HT16K33_Emulator(0x71), HT16K33_Emulator(0x72), HT16K33_Emulator(0x73),
+        HT16K33_Emulator(0x74), HT16K33_Emulator(0x75), HT16K33_Emulator(0x76), HT16K33_Emulator(0x77)
+    };
+
+    for (auto& emulator : emulators) Sim::attach(&emulator);
+
+    // Bring up the app's platform, then the network, which sets the RTC
+    HAL_Init();
+    I2C::setup();
+    Config::Network::open();
+    Sim::advance((uint64_t)(options.networkDelayMs + 1000) * 1000);
+
+    Prefs prefs = {};
+    prefs.mode = true;
+    prefs.bst = true;
+    prefs.colon = true;
+    prefs.flash = true;
+    prefs.brightness = 15;
+
+    DisplayGroup clockDisplay(0x70, 1);
+    clockDisplay.init(prefs.brightness);
+    I2C::flush(100);
+    Clock clock(prefs, clockDisplay);
+    HT16K33_Segment& display = clockDisplay.panel(0);
+
+    // Pure conversions
+    Bench::run("clock.bcd", 1000, [](uint32_t i) {
+        Bench::keep(Clock::bcd(i % 60));
+    });
+
+    Bench::run("civil.weekday_from_days", 1000, [](uint32_t i) {
+        Bench::keep(weekday_from_days((int32_t)(19000 + i)));
+    });
+
+    Bench::run("civil.time_from_epoch", 1000, [](uint32_t i) {
+        Bench::keep(civil_time_from_epoch(BASE_TIME + (int64_t)i * 37));
+    });
+
+    // The path civil_time.h replaced, over the same times: format
+    // the time with the C library, then parse the fields back out
+    Bench::run("civil.time_from_epoch.libc", 1000, [](uint32_t i) {
+        const time_t secs = (time_t)(BASE_TIME + (int64_t)i * 37);
+        struct tm timeStore;
+        char timestamp[65];
+        unsigned long fields[6] = {0};
+        if (strftime(timestamp, 64, "%F %T", gmtime_r(&secs, &timeStore)) > 0) {
+            sscanf(timestamp, "%lu-%lu-%lu %lu:%lu:%lu", &fields[0], &fields[1], &fields[2], &fields[3], &fields[4], &fields[5]);
+        }
+
+        Bench::keep(fields);
+    });
+
+    // DST, within one period, and across many years
+    DST::Zone zone(DST::RULES::UK);
+    Bench::run("dst.offset", 1000, [&zone](uint32_t i) {
+        Bench::keep(zone.offset(BASE_TIME + i));
+    });
+
+    Bench::run("dst.offset.year_change", 1000, [&zone](uint32_t i) {
+        Bench::keep(zone.offset(BASE_TIME + (int64_t)(i % 64) * 31556952));
+    });
+
+    // Reading the RTC
+    Bench::run("clock.set_time_from_rtc", 1000, [&clock](uint32_t) {
+        Bench::keep(clock.setTimeFromRTC());
+    });
+
+    // Prefs parsing, by payload size. Parsing is in place,
+    // so each operation includes copying in the payload, as
+    // the app does when it reads the config response
+    static const char* const PAYLOADS[][2] = {
+        { "config.parse_prefs.small",  "{\"mode\":true,\"brightness\":8}" },
+        { "config.parse_prefs.full",   "{\"mode\":true,\"bst\":true,\"colon\":true,\"flash\":false,\"brightness\":8,\"led\":false,"
+                                       "\"tz\":\"CET-1CEST,M3.5.0,M10.5.0/3\"}" },
+        { "config.parse_prefs.unknown_keys", "{\"mode\":true,\"bst\":true,\"colon\":true,\"flash\":false,\"brightness\":8,\"led\":false,"
+                                       "\"tz\":\"EST5EDT,M3.2.0,M11.1.0\",\"location\":{\"lat\":51.5072,\"lng\":-0.1276},"
+                                       "\"owner\":\"A. N. Other\",\"notes\":[\"kitchen\",\"ground floor\",\"spare\"]}" }
+    };
+
+    for (const auto& payload : PAYLOADS) {
+        const size_t length = strlen(payload[1]);
+        Bench::run(payload[0], 1000, [&payload, length](uint32_t) {
+            static char json[257];
+            static Prefs parsed;
+            memcpy(json, payload[1], length);
+            Bench::keep(Config::parsePrefs(json, length, parsed));
+        });
+    }
+
+    // Display driver
+    static const char CHARS[] = "0123456789abcdef-";
+    Bench::run("display.set_alpha", 1000, [&display](uint32_t i) {
+        display.setAlpha(CHARS[i % 17], i & 3, false);
+    });
+
+    Bench::run("display.set_text", 1000, [&display](uint32_t i) {
+        display.setText((i & 1) ? "12.34" : "no net");
+    });
+
+    // One scroll step: a shift and one glyph lookup. Restarting
+    // the message is included once per pass over it
+    static const char MESSAGE[] = "config version 0.1.4";
+    TextScroller scroller(MESSAGE);
+    Bench::run("text.scroll.step", 1000, [&scroller, &display](uint32_t) {
+        if (!scroller.step()) scroller.start(MESSAGE);
+        scroller.render(display);
+    });
+
+    // Other panel types, built from the same driver core
+    HT16K33_Alphanumeric alphanumeric(0x71);
+    Bench::run("alphanumeric.set_text", 1000, [&alphanumeric](uint32_t i) {
+        alphanumeric.setText((i & 1) ? "12.34" : "no net");
+    });
+
+    HT16K33_Matrix matrix(0x72);
+    Bench::run("matrix.set_pixel", 1000, [&matrix](uint32_t i) {
+        matrix.setPixel(i & 7, (i >> 3) & 7, (i & 64) == 0);
+    });
+
+    HT16K33_Bargraph bargraph(0x73);
+    Bench::run("bargraph.set_bar", 1000, [&bargraph](uint32_t i) {
+        bargraph.setBar(i % 24, (BAR_COLOR)(i & 3));
+    });
+
+    Bench::run("display.draw.unchanged", 1000, [&display](uint32_t) {
+        display.draw();
+    }, [&display]() {
+        display.draw();
+        I2C::flush(100);
+    });
+
+    // A changed frame queues a bus transaction, so let the
+    // queue drain between batches
+    Bench::run("display.draw.changed", I2C::QUEUE_LENGTH, [&display](uint32_t i) {
+        display.setColon((i & 1) != 0);
+        display.draw();
+    }, []() {
+        I2C::flush(100);
+    });
+
+    // Display groups, one and eight panels, with a changed
+    // colon on every panel in every frame. The time per
+    // operation should grow in line with the panel count
+    for (uint32_t panelCount : {1u, 8u}) {
+        DisplayGroup group(0x70, panelCount);
+        group.init(15);
+        I2C::flush(100);
+
+        const std::string name = "display_group.draw.changed." + std::to_string(panelCount) + "_panels";
+        Bench::run(name.c_str(), I2C::QUEUE_LENGTH, [&group](uint32_t i) {
+            for (uint32_t p = 0 ; p < group.size() ; ++p) group.panel(p).setColon((i & 1) != 0);
+            group.draw();
+        }, []() {
+            I2C::flush(100);
+        });
+    }
+
+    // One animation frame rolling all four digits, as at the
+    // turn of an hour, on the clock's single panel
+    Animator animator(clockDisplay);
+    DigitRoll rolls[4] = { DigitRoll(0), DigitRoll(1), DigitRoll(2), DigitRoll(3) };
+    for (auto& roll : rolls) roll.set(0x7F, 0x3F);
+    Bench::run("animator.render.roll", 1000, [&animator, &rolls](uint32_t i) {
+        if (i % 3 == 0) for (auto& roll : rolls) animator.play(roll);
+        animator.render();
+    });
+
+    // One full pass of the clock, a second apart
+    uint32_t waitMs = 0;
+    Bench::run("clock.tick", 1, [&clock, &waitMs](uint32_t) {
+        waitMs = clock.tick();
+    }, [&waitMs]() {
+        Sim::advance((uint64_t)waitMs * 1000);
+    });
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * Microvisor Clock Demo -- host simulation: Microvisor system call stand-in
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Declares the Microvisor system calls, and their types, that the
+ * app uses. They are implemented in `sim/mv_mock.cpp`, which models
+ * the network, the config fetch channel and the notification center.
+ *
+ */
+#ifndef MV_SYSCALLS_H
+#define MV_SYSCALLS_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * ENUMERATIONS
+ */
+enum MvStatus {
+    MV_STATUS_OKAY = 0,
+    MV_STATUS_PARAMETERFAULT = 1,
+    MV_STATUS_UNAVAILABLE = 7,
+    MV_STATUS_INVALIDHANDLE = 11,
+    MV_STATUS_CHANNELCLOSED = 19
+};
+
+enum MvEventType {
+    MV_EVENTTYPE_NETWORKSTATUSCHANGED = 1,
+    MV_EVENTTYPE_CHANNELDATAREADABLE = 8,
+    MV_EVENTTYPE_CHANNELNOTCONNECTED = 10
+};
+
+enum MvNetworkStatus {
+    MV_NETWORKSTATUS_DELIBERATELYOFFLINE = 0,
+    MV_NETWORKSTATUS_CONNECTED = 1,
+    MV_NETWORKSTATUS_CONNECTING = 2
+};
+
+enum MvChannelType {
+    MV_CHANNELTYPE_OPAQUEBYTES = 0,
+    MV_CHANNELTYPE_HTTP = 1,
+    MV_CHANNELTYPE_CONFIGFETCH = 2
+};
+
+enum MvConfigKeyFetchScope {
+    MV_CONFIGKEYFETCHSCOPE_ACCOUNT = 1,
+    MV_CONFIGKEYFETCHSCOPE_DEVICE = 2
+};
+
+enum MvConfigKeyFetchStore {
+    MV_CONFIGKEYFETCHSTORE_CONFIG = 1,
+    MV_CONFIGKEYFETCHSTORE_SECRET = 2
+};
+
+enum MvConfigFetchResult {
+    MV_CONFIGFETCHRESULT_OK = 0,
+    MV_CONFIGFETCHRESULT_RESPONSETOOLARGE = 1
+};
+
+enum MvConfigKeyFetchResult {
+    MV_CONFIGKEYFETCHRESULT_OK = 0,
+    MV_CONFIGKEYFETCHRESULT_KEYNOTFOUND = 1
+};
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct MvNotificationHandleOpaque*  MvNotificationHandle;
+typedef struct MvNetworkHandleOpaque*       MvNetworkHandle;
+typedef struct MvChannelHandleOpaque*       MvChannelHandle;
+
+struct MvNotification {
+    uint64_t                    microseconds;
+    enum MvEventType            event_type;
+    uint32_t                    tag;
+};
+
+struct MvNotificationSetup {
+    uint32_t                    irq;
+    struct MvNotification*      buffer;
+    uint32_t                    buffer_size;
+};
+
+struct MvSizedString {
+    const uint8_t*              data;
+    uint32_t                    length;
+};
+
+struct MvRequestNetworkParams {
+    uint32_t                    version;
+    union {
+        struct {
+            MvNotificationHandle    notification_handle;
+            uint32_t                notification_tag;
+        } v1;
+    };
+};
+
+struct MvOpenChannelParams {
+    uint32_t                    version;
+    union {
+        struct {
+            MvNotificationHandle    notification_handle;
+            uint32_t                notification_tag;
+            MvNetworkHandle         network_handle;
+            uint8_t*                receive_buffer;
+            uint32_t                receive_buffer_len;
+            uint8_t*                send_buffer;
+            uint32_t                send_buffer_len;
+            enum MvChannelType      channel_type;
+            struct MvSizedString    endpoint;
+        } v1;
+    };
+};
+
+struct MvConfigKeyToFetch {
+    enum MvConfigKeyFetchScope  scope;
+    enum MvConfigKeyFetchStore  store;
+    struct MvSizedString        key;
+};
+
+struct MvConfigKeyFetchParams {
+    uint32_t                    num_items;
+    struct MvConfigKeyToFetch*  keys_to_fetch;
+};
+
+struct MvConfigResponseData {
+    enum MvConfigFetchResult    result;
+    uint32_t                    num_items;
+};
+
+struct MvOutputBuffer {
+    uint8_t*                    data;
+    uint32_t                    size;
+    uint32_t*                   length;
+};
+
+struct MvConfigResponseReadItemParams {
+    uint32_t                    item_index;
+    enum MvConfigKeyFetchResult* result;
+    struct MvOutputBuffer       buf;
+};
+
+typedef struct MvNotification                   MvNotification;
+typedef struct MvNotificationSetup              MvNotificationSetup;
+typedef struct MvRequestNetworkParams           MvRequestNetworkParams;
+typedef struct MvOpenChannelParams              MvOpenChannelParams;
+typedef struct MvConfigKeyToFetch               MvConfigKeyToFetch;
+typedef struct MvConfigKeyFetchParams           MvConfigKeyFetchParams;
+typedef struct MvConfigResponseData             MvConfigResponseData;
+typedef struct MvConfigResponseReadItemParams   MvConfigResponseReadItemParams;
+typedef enum MvNetworkStatus                    MvNetworkStatus;
+
+
+/*
+ * PROTOTYPES
+ */
+enum MvStatus   mvGetWallTime(uint64_t* usec);
+enum MvStatus   mvGetMicroseconds(uint64_t* usec);
+enum MvStatus   mvGetHClk(uint32_t* hz);
+enum MvStatus   mvGetPClk1(uint32_t* hz);
+enum MvStatus   mvGetDeviceId(uint8_t* buffer, uint32_t length);
+enum MvStatus   mvServerLoggingInit(uint8_t* buffer, uint32_t length);
+enum MvStatus   mvServerLog(const uint8_t* text, uint16_t length);
+enum MvStatus   mvSetupNotifications(const struct MvNotificationSetup* setup, MvNotificationHandle* handle);
+enum MvStatus   mvRequestNetwork(struct MvRequestNetworkParams* params, MvNetworkHandle* handle);
+enum MvStatus   mvReleaseNetwork(MvNetworkHandle* handle);
+enum MvStatus   mvGetNetworkStatus(MvNetworkHandle handle, enum MvNetworkStatus* status);
+enum MvStatus   mvOpenChannel(const struct MvOpenChannelParams* params, MvChannelHandle* handle);
+enum MvStatus   mvCloseChannel(MvChannelHandle* handle);
+enum MvStatus   mvSendConfigFetchRequest(MvChannelHandle handle, const struct MvConfigKeyFetchParams* request);
+enum MvStatus   mvReadConfigFetchResponseData(MvChannelHandle handle, struct MvConfigResponseData* response);
+enum MvStatus   mvReadConfigResponseItem(MvChannelHandle handle, const struct MvConfigResponseReadItemParams* item);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  // MV_SYSCALLS_H
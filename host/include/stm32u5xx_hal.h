@@ -0,0 +1,282 @@
+/*
+ * Microvisor Clock Demo -- host simulation: STM32U5 HAL stand-in
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Declares just the parts of the STM32U5 HAL and CMSIS that the
+ * app uses, so the app's sources build unchanged for Linux. The
+ * functions are implemented in `sim/hal_mock.cpp` on top of the
+ * simulator's virtual clock and interrupt controller.
+ *
+ */
+#ifndef STM32U5XX_HAL_H
+#define STM32U5XX_HAL_H
+
+
+/*
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * TYPES
+ */
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef int32_t IRQn_Type;
+
+// Peripheral instances are only compared, never dereferenced
+typedef struct { uint32_t id; } SIM_Peripheral;
+
+typedef struct {
+    uint32_t            Pin;
+    uint32_t            Mode;
+    uint32_t            Pull;
+    uint32_t            Speed;
+    uint32_t            Alternate;
+} GPIO_InitTypeDef;
+
+typedef struct {
+    uint32_t            PeriphClockSelection;
+    uint32_t            I2c1ClockSelection;
+    uint32_t            Usart2ClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+typedef struct {
+    uint32_t            Timing;
+    uint32_t            AddressingMode;
+    uint32_t            DualAddressMode;
+    uint32_t            OwnAddress1;
+    uint32_t            OwnAddress2;
+    uint32_t            OwnAddress2Masks;
+    uint32_t            GeneralCallMode;
+    uint32_t            NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef struct {
+    SIM_Peripheral*     Instance;
+    I2C_InitTypeDef     Init;
+    uint32_t            ErrorCode;
+} I2C_HandleTypeDef;
+
+typedef struct {
+    uint32_t            Request;
+    uint32_t            BlkHWRequest;
+    uint32_t            Direction;
+    uint32_t            SrcInc;
+    uint32_t            DestInc;
+    uint32_t            SrcDataWidth;
+    uint32_t            DestDataWidth;
+    uint32_t            Priority;
+    uint32_t            SrcBurstLength;
+    uint32_t            DestBurstLength;
+    uint32_t            TransferAllocatedPort;
+    uint32_t            TransferEventMode;
+    uint32_t            Mode;
+} DMA_InitTypeDef;
+
+typedef struct {
+    SIM_Peripheral*     Instance;
+    DMA_InitTypeDef     Init;
+    void*               Parent;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    uint32_t            BaudRate;
+    uint32_t            WordLength;
+    uint32_t            StopBits;
+    uint32_t            Parity;
+    uint32_t            Mode;
+    uint32_t            HwFlowCtl;
+} UART_InitTypeDef;
+
+typedef struct {
+    SIM_Peripheral*     Instance;
+    UART_InitTypeDef    Init;
+    DMA_HandleTypeDef*  hdmatx;
+} UART_HandleTypeDef;
+
+typedef struct {
+    uint32_t            TypeErase;
+    uint32_t            Banks;
+    uint32_t            Page;
+    uint32_t            NbPages;
+} FLASH_EraseInitTypeDef;
+
+
+/*
+ * PERIPHERALS
+ */
+extern SIM_Peripheral SIM_GPIOA, SIM_GPIOB, SIM_GPIOD, SIM_I2C1, SIM_USART2, SIM_GPDMA1_CH0, SIM_FLASH;
+
+#define GPIOA                           (&SIM_GPIOA)
+#define GPIOB                           (&SIM_GPIOB)
+#define GPIOD                           (&SIM_GPIOD)
+#define I2C1                            (&SIM_I2C1)
+#define USART2                          (&SIM_USART2)
+#define GPDMA1_Channel0                 (&SIM_GPDMA1_CH0)
+#define FLASH                           (&SIM_FLASH)
+
+
+/*
+ * CONSTANTS
+ */
+#define GPIO_PIN_5                      ((uint16_t)0x0020)
+#define GPIO_PIN_6                      ((uint16_t)0x0040)
+#define GPIO_PIN_9                      ((uint16_t)0x0200)
+
+enum {
+    // GPIO
+    GPIO_MODE_OUTPUT_PP = 1, GPIO_MODE_AF_PP, GPIO_MODE_AF_OD,
+    GPIO_NOPULL, GPIO_PULLUP,
+    GPIO_SPEED_FREQ_LOW, GPIO_SPEED_FREQ_HIGH, GPIO_SPEED_FREQ_VERY_HIGH,
+    GPIO_AF4_I2C1, GPIO_AF7_USART2,
+    // RCC
+    RCC_PERIPHCLK_I2C1, RCC_I2C1CLKSOURCE_PCLK1, RCC_PERIPHCLK_USART2, RCC_USART2CLKSOURCE_PCLK1,
+    // I2C
+    I2C_ADDRESSINGMODE_7BIT, I2C_DUALADDRESS_DISABLE, I2C_OA2_NOMASK,
+    I2C_GENERALCALL_DISABLE, I2C_NOSTRETCH_ENABLE, I2C_NOSTRETCH_DISABLE,
+    // UART
+    UART_WORDLENGTH_8B, UART_STOPBITS_1, UART_PARITY_NONE, UART_MODE_TX, UART_HWCONTROL_NONE,
+    // DMA
+    GPDMA1_REQUEST_USART2_TX, DMA_BREQ_SINGLE_BURST, DMA_MEMORY_TO_PERIPH,
+    DMA_SINC_INCREMENTED, DMA_DINC_FIXED, DMA_SRC_DATAWIDTH_BYTE, DMA_DEST_DATAWIDTH_BYTE,
+    DMA_LOW_PRIORITY_LOW_WEIGHT, DMA_TCEM_BLOCK_TRANSFER, DMA_NORMAL
+};
+
+#define DMA_SRC_ALLOCATED_PORT0         0x00u
+#define DMA_DEST_ALLOCATED_PORT0        0x00u
+
+// Sequential transfer options. Each value records whether the
+// frame ends the transaction with a STOP
+#define I2C_FIRST_FRAME                 0x00u
+#define I2C_OTHER_FRAME                 0x01u
+#define I2C_FIRST_AND_LAST_FRAME        0x10u
+#define I2C_OTHER_AND_LAST_FRAME        0x11u
+#define I2C_LAST_FRAME                  0x12u
+#define I2C_FRAME_HAS_STOP(option)      (((option) & 0x10u) != 0)
+
+#define HAL_I2C_ERROR_NONE              0x00u
+#define HAL_I2C_ERROR_AF                0x04u
+
+// Interrupts the simulator can raise
+enum {
+    GPDMA1_Channel0_IRQn = 29,
+    TIM8_BRK_IRQn = 43,
+    I2C1_EV_IRQn = 55,
+    I2C1_ER_IRQn = 56,
+    USART2_IRQn = 62
+};
+
+#define TICK_INT_PRIORITY               15u
+
+// Flash. Host memory stands in for it, so the first bank
+// spans the low address space
+#define FLASH_BASE                      0x00000000UL
+#define FLASH_BANK_SIZE                 0x80000000UL
+#define FLASH_PAGE_SIZE                 0x2000U
+#define FLASH_BANK_1                    0x01u
+#define FLASH_BANK_2                    0x02u
+#define FLASH_TYPEERASE_PAGES           0x02u
+#define FLASH_TYPEPROGRAM_QUADWORD      0x01u
+
+
+/*
+ * MACROS
+ */
+#define UNUSED(x)                       ((void)(x))
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    do {} while (0);
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    do {} while (0);
+#define __HAL_RCC_GPIOD_CLK_ENABLE()    do {} while (0);
+#define __HAL_RCC_I2C1_CLK_ENABLE()     do {} while (0);
+#define __HAL_RCC_USART2_CLK_ENABLE()   do {} while (0);
+#define __HAL_RCC_GPDMA1_CLK_ENABLE()   do {} while (0);
+#define __HAL_LINKDMA(handle, field, dma) do { (handle)->field = &(dma); (dma).Parent = (handle); } while (0)
+
+// Core instructions, mapped onto the simulator
+#define __WFI()                         SIM_WaitForInterrupt()
+#define __disable_irq()                 SIM_SetPrimask(1)
+#define __enable_irq()                  SIM_SetPrimask(0)
+#define __get_PRIMASK()                 SIM_GetPrimask()
+#define __set_PRIMASK(mask)             SIM_SetPrimask(mask)
+#define __DMB()                         __atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+
+/*
+ * PROTOTYPES
+ */
+// Simulated core
+void                SIM_WaitForInterrupt(void);
+uint32_t            SIM_GetPrimask(void);
+void                SIM_SetPrimask(uint32_t mask);
+
+// HAL
+HAL_StatusTypeDef   HAL_Init(void);
+HAL_StatusTypeDef   HAL_InitTick(uint32_t priority);
+void                SystemCoreClockUpdate(void);
+uint32_t            HAL_GetTick(void);
+void                HAL_Delay(uint32_t delay);
+void                HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preemptPriority, uint32_t subPriority);
+void                HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void                NVIC_EnableIRQ(IRQn_Type irq);
+void                NVIC_ClearPendingIRQ(IRQn_Type irq);
+HAL_StatusTypeDef   HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init);
+
+void                HAL_GPIO_Init(SIM_Peripheral* port, GPIO_InitTypeDef* init);
+void                HAL_GPIO_WritePin(SIM_Peripheral* port, uint16_t pin, GPIO_PinState state);
+void                HAL_GPIO_TogglePin(SIM_Peripheral* port, uint16_t pin);
+
+HAL_StatusTypeDef   HAL_I2C_Init(I2C_HandleTypeDef* i2c);
+HAL_StatusTypeDef   HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* i2c, uint16_t address, uint32_t trials, uint32_t timeout);
+uint32_t            HAL_I2C_GetError(I2C_HandleTypeDef* i2c);
+HAL_StatusTypeDef   HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* i2c, uint16_t address, uint8_t* data, uint16_t size, uint32_t option);
+HAL_StatusTypeDef   HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* i2c, uint16_t address, uint8_t* data, uint16_t size, uint32_t option);
+HAL_StatusTypeDef   HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* i2c, uint16_t address);
+void                HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MspInit(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_ErrorCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef* i2c);
+
+HAL_StatusTypeDef   HAL_DMA_Init(DMA_HandleTypeDef* dma);
+void                HAL_DMA_IRQHandler(DMA_HandleTypeDef* dma);
+
+HAL_StatusTypeDef   HAL_UART_Init(UART_HandleTypeDef* uart);
+HAL_StatusTypeDef   HAL_UART_Transmit_DMA(UART_HandleTypeDef* uart, const uint8_t* data, uint16_t size);
+void                HAL_UART_IRQHandler(UART_HandleTypeDef* uart);
+void                HAL_UART_MspInit(UART_HandleTypeDef* uart);
+void                HAL_UART_TxCpltCallback(UART_HandleTypeDef* uart);
+
+HAL_StatusTypeDef   HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef   HAL_FLASH_Lock(void);
+HAL_StatusTypeDef   HAL_FLASH_Program(uint32_t type, uint32_t address, uint32_t dataAddress);
+HAL_StatusTypeDef   HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* erase, uint32_t* pageError);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  // STM32U5XX_HAL_H
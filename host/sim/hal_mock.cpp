@@ -0,0 +1,450 @@
+/*
+ * Microvisor Clock Demo -- host simulation: STM32U5 HAL stand-in
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Just enough of the HAL for the app: the tick, GPIO, NVIC,
+ * interrupt-driven I2C and DMA UART transfers, and flash. Transfers
+ * take the bus time they would on the device, then raise the
+ * peripheral's interrupt, whose handler calls the app's HAL callbacks.
+ * Flash is host memory, which follows the device's erase and
+ * programming rules.
+ *
+ */
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "sim.h"
+
+
+/*
+ * GLOBALS
+ */
+SIM_Peripheral SIM_GPIOA = { 0 };
+SIM_Peripheral SIM_GPIOB = { 1 };
+SIM_Peripheral SIM_GPIOD = { 3 };
+SIM_Peripheral SIM_I2C1 = { 0x10 };
+SIM_Peripheral SIM_USART2 = { 0x20 };
+SIM_Peripheral SIM_GPDMA1_CH0 = { 0x30 };
+
+// The prefs store's flash pages, which the device's linker script places
+extern "C" {
+__attribute__((aligned(FLASH_PAGE_SIZE))) uint8_t __prefs_store_start[2 * FLASH_PAGE_SIZE];
+}
+SIM_Peripheral SIM_FLASH = { 0x40 };
+
+// LED pin, PA5
+static constexpr uint16_t   LED_PIN = GPIO_PIN_5;
+static bool                 ledState = false;
+
+// The I2C transfer in progress
+static struct {
+    bool                    busy;
+    bool                    complete;
+    bool                    isRead;
+    bool                    inTransaction;      // A frame has ended without a STOP
+    bool                    isAborting;
+    uint32_t                frame;              // Counts frames, so an aborted one's events are ignored
+    I2C_HandleTypeDef*      handle;
+    Sim::I2CDevice*         device;             // The device last addressed
+} i2cTransfer = { false, false, false, false, false, 0, nullptr, nullptr };
+
+// The UART transfer in progress
+static bool                 uartBusy = false;
+static bool                 uartComplete = false;
+
+// Flash timings, typical for the STM32U5
+static constexpr uint64_t   FLASH_PROGRAM_US = 120;
+static constexpr uint64_t   FLASH_ERASE_US = 1500;
+static bool                 flashUnlocked = false;
+
+
+/**
+ * @brief Set the LED and report any change.
+ *
+ * @param state: The new LED state.
+ */
+static void setLED(bool state) {
+
+    if (state != ledState) {
+        ledState = state;
+        Sim::count("led changes");
+    }
+}
+
+
+/**
+ * @brief Start an I2C frame: address the device, then move the bytes
+ *        once the bus time has passed and raise the event interrupt.
+ *
+ * @param i2c:     The HAL I2C handle.
+ * @param address: The device address, shifted left one bit.
+ * @param data:    The bytes to send, or the buffer to fill.
+ * @param size:    The number of bytes.
+ * @param option:  The HAL sequential transfer option.
+ * @param isRead:  Is this a read?
+ *
+ * @returns HAL_OK if the frame started, or HAL_BUSY.
+ */
+static HAL_StatusTypeDef startFrame(I2C_HandleTypeDef* i2c, uint16_t address, uint8_t* data, uint16_t size, uint32_t option, bool isRead) {
+
+    if (i2cTransfer.busy) return HAL_BUSY;
+
+    i2cTransfer.busy = true;
+    i2cTransfer.complete = false;
+    i2cTransfer.isRead = isRead;
+    i2cTransfer.handle = i2c;
+    const uint32_t frame = ++i2cTransfer.frame;
+    Sim::count(isRead ? "i2c frames read" : "i2c frames written");
+
+    Sim::I2CDevice* device = Sim::device((uint8_t)(address >> 1));
+    if (device == nullptr) {
+        // No ACK to the address byte
+        Sim::at(Sim::now() + Sim::i2cTransferTime(0), [i2c, frame]() {
+            if (frame != i2cTransfer.frame) return;
+            i2c->ErrorCode = HAL_I2C_ERROR_AF;
+            if (i2cTransfer.inTransaction) i2cTransfer.device->stop();
+            i2cTransfer.inTransaction = false;
+            Sim::raise(I2C1_ER_IRQn);
+        });
+
+        return HAL_OK;
+    }
+
+    const bool hasStop = I2C_FRAME_HAS_STOP(option);
+    Sim::at(Sim::now() + Sim::i2cTransferTime(size) + device->stretchTime(), [device, data, size, hasStop, isRead, frame]() {
+        if (frame != i2cTransfer.frame) return;
+
+        // A repeated START to another device ends the last one's transfer
+        if (i2cTransfer.inTransaction && i2cTransfer.device != device) i2cTransfer.device->stop();
+        i2cTransfer.device = device;
+        device->start(isRead);
+        bool acked = true;
+        for (uint16_t i = 0 ; i < size && acked ; ++i) {
+            if (isRead) {
+                data[i] = device->read();
+            } else {
+                acked = device->write(data[i]);
+            }
+        }
+
+        Sim::count(isRead ? "i2c bytes read" : "i2c bytes written", size);
+        if (hasStop || !acked) device->stop();
+        i2cTransfer.inTransaction = !hasStop && acked;
+        if (acked) {
+            i2cTransfer.complete = true;
+            Sim::raise(I2C1_EV_IRQn);
+        } else {
+            i2cTransfer.handle->ErrorCode = HAL_I2C_ERROR_AF;
+            Sim::raise(I2C1_ER_IRQn);
+        }
+    });
+
+    return HAL_OK;
+}
+
+
+extern "C" {
+
+/*
+ * CORE
+ */
+void SIM_WaitForInterrupt(void) {
+
+    Sim::waitForInterrupt();
+}
+
+
+uint32_t SIM_GetPrimask(void) {
+
+    return Sim::primask();
+}
+
+
+void SIM_SetPrimask(uint32_t mask) {
+
+    Sim::setPrimask(mask);
+}
+
+
+/*
+ * SYSTEM
+ */
+HAL_StatusTypeDef HAL_Init(void) {
+
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_InitTick([[maybe_unused]] uint32_t priority) {
+
+    return HAL_OK;
+}
+
+
+void SystemCoreClockUpdate(void) {}
+
+
+uint32_t HAL_GetTick(void) {
+
+    return (uint32_t)(Sim::now() / 1000);
+}
+
+
+void HAL_Delay(uint32_t delay) {
+
+    // The HAL adds a tick to guarantee the minimum wait
+    Sim::advance((uint64_t)(delay + 1) * 1000);
+}
+
+
+void HAL_NVIC_SetPriority([[maybe_unused]] IRQn_Type irq, [[maybe_unused]] uint32_t preemptPriority, [[maybe_unused]] uint32_t subPriority) {}
+
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) {
+
+    Sim::enable(irq);
+}
+
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+
+    Sim::enable(irq);
+}
+
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+
+    Sim::clearPending(irq);
+}
+
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig([[maybe_unused]] RCC_PeriphCLKInitTypeDef* init) {
+
+    return HAL_OK;
+}
+
+
+/*
+ * GPIO
+ */
+void HAL_GPIO_Init([[maybe_unused]] SIM_Peripheral* port, [[maybe_unused]] GPIO_InitTypeDef* init) {}
+
+
+void HAL_GPIO_WritePin(SIM_Peripheral* port, uint16_t pin, GPIO_PinState state) {
+
+    if (port == GPIOA && (pin & LED_PIN) != 0) setLED(state == GPIO_PIN_SET);
+}
+
+
+void HAL_GPIO_TogglePin(SIM_Peripheral* port, uint16_t pin) {
+
+    if (port == GPIOA && (pin & LED_PIN) != 0) setLED(!ledState);
+}
+
+
+/*
+ * I2C
+ */
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* i2c) {
+
+    i2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    HAL_I2C_MspInit(i2c);
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady([[maybe_unused]] I2C_HandleTypeDef* i2c, uint16_t address, [[maybe_unused]] uint32_t trials, [[maybe_unused]] uint32_t timeout) {
+
+    Sim::advance(Sim::i2cTransferTime(0));
+    return Sim::device((uint8_t)(address >> 1)) != nullptr ? HAL_OK : HAL_ERROR;
+}
+
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* i2c) {
+
+    return i2c->ErrorCode;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* i2c, uint16_t address, uint8_t* data, uint16_t size, uint32_t option) {
+
+    return startFrame(i2c, address, data, size, option, false);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* i2c, uint16_t address, uint8_t* data, uint16_t size, uint32_t option) {
+
+    return startFrame(i2c, address, data, size, option, true);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* i2c, [[maybe_unused]] uint16_t address) {
+
+    // Too late if the frame has already ended
+    if (!i2cTransfer.busy || i2cTransfer.complete || i2cTransfer.isAborting) return HAL_ERROR;
+
+    // Drop the frame's pending events and send a STOP
+    i2cTransfer.isAborting = true;
+    i2cTransfer.frame++;
+    Sim::count("i2c aborts");
+    Sim::at(Sim::now() + Sim::i2cTransferTime(0), [i2c]() {
+        if (i2cTransfer.inTransaction) i2cTransfer.device->stop();
+        i2cTransfer.inTransaction = false;
+        i2c->ErrorCode = HAL_I2C_ERROR_NONE;
+        Sim::raise(I2C1_ER_IRQn);
+    });
+
+    return HAL_OK;
+}
+
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* i2c) {
+
+    if (!i2cTransfer.busy || !i2cTransfer.complete) return;
+
+    // Free the peripheral before the callback, which may start the next frame
+    i2cTransfer.busy = false;
+    i2cTransfer.complete = false;
+    if (i2cTransfer.isRead) {
+        HAL_I2C_MasterRxCpltCallback(i2c);
+    } else {
+        HAL_I2C_MasterTxCpltCallback(i2c);
+    }
+}
+
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* i2c) {
+
+    if (!i2cTransfer.busy) return;
+
+    i2cTransfer.busy = false;
+    if (i2cTransfer.isAborting) {
+        i2cTransfer.isAborting = false;
+        HAL_I2C_AbortCpltCallback(i2c);
+        return;
+    }
+
+    Sim::count("i2c errors");
+    HAL_I2C_ErrorCallback(i2c);
+}
+
+
+/*
+ * DMA
+ */
+HAL_StatusTypeDef HAL_DMA_Init([[maybe_unused]] DMA_HandleTypeDef* dma) {
+
+    return HAL_OK;
+}
+
+
+void HAL_DMA_IRQHandler([[maybe_unused]] DMA_HandleTypeDef* dma) {}
+
+
+/*
+ * UART
+ */
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* uart) {
+
+    HAL_UART_MspInit(uart);
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* uart, [[maybe_unused]] const uint8_t* data, uint16_t size) {
+
+    if (uartBusy) return HAL_BUSY;
+
+    // Ten bits per byte on the wire
+    uartBusy = true;
+    const uint64_t timeUs = ((uint64_t)size * 10 * 1000000) / uart->Init.BaudRate;
+    Sim::count("uart bytes", size);
+    Sim::at(Sim::now() + timeUs, []() {
+        uartComplete = true;
+        Sim::raise(USART2_IRQn);
+    });
+
+    return HAL_OK;
+}
+
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef* uart) {
+
+    if (!uartComplete) return;
+
+    uartBusy = false;
+    uartComplete = false;
+    HAL_UART_TxCpltCallback(uart);
+}
+
+
+/*
+ * FLASH
+ */
+/**
+ * @brief Make a range of flash writable. The app's flash
+ *        is in its image, which the host maps read-only.
+ *
+ * @param address: The start of the range.
+ * @param length:  The length of the range in bytes.
+ *
+ * @returns A pointer to the range.
+ */
+static uint8_t* writableFlash(uint32_t address, uint32_t length) {
+
+    const uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t start = (uintptr_t)address & ~(pageSize - 1);
+    mprotect((void*)start, (uintptr_t)address + length - start, PROT_READ | PROT_WRITE);
+    return (uint8_t*)(uintptr_t)address;
+}
+
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+
+    flashUnlocked = true;
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+
+    flashUnlocked = false;
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t address, uint32_t dataAddress) {
+
+    constexpr uint32_t QUAD_WORD_B = 16;
+    if (!flashUnlocked || type != FLASH_TYPEPROGRAM_QUADWORD || address % QUAD_WORD_B != 0) return HAL_ERROR;
+
+    // A quad-word can only be programmed once between erases
+    uint8_t* target = writableFlash(address, QUAD_WORD_B);
+    for (uint32_t i = 0 ; i < QUAD_WORD_B ; ++i) {
+        if (target[i] != 0xFF) return HAL_ERROR;
+    }
+
+    memcpy(target, (const void*)(uintptr_t)dataAddress, QUAD_WORD_B);
+    Sim::count("flash quad-words written");
+    Sim::advance(FLASH_PROGRAM_US);
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* erase, uint32_t* pageError) {
+
+    *pageError = 0xFFFFFFFF;
+    if (!flashUnlocked || erase->TypeErase != FLASH_TYPEERASE_PAGES) return HAL_ERROR;
+
+    const uint32_t address = FLASH_BASE + (erase->Banks == FLASH_BANK_2 ? FLASH_BANK_SIZE : 0) + erase->Page * FLASH_PAGE_SIZE;
+    memset(writableFlash(address, erase->NbPages * FLASH_PAGE_SIZE), 0xFF, erase->NbPages * FLASH_PAGE_SIZE);
+    Sim::count("flash pages erased", erase->NbPages);
+    Sim::advance(FLASH_ERASE_US * erase->NbPages);
+    return HAL_OK;
+}
+
+
+}   // extern "C"
@@ -0,0 +1,196 @@
+/*
+ * Microvisor Clock Demo -- host simulation: HT16K33 emulator
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#include <cstdio>
+#include "ht16k33_emulator.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Display RAM offsets of the four digits, and of the colon
+static constexpr uint8_t    DIGIT_ROWS[4] = {0, 2, 6, 8};
+static constexpr uint8_t    COLON_ROW = 4;
+static constexpr uint8_t    COLON_BIT = 0x02;
+static constexpr uint8_t    DOT_BIT = 0x80;
+
+// Seven-segment patterns and the characters they best show
+static constexpr struct {
+    uint8_t                 segments;
+    char                    character;
+} GLYPHS[] = {
+    {0x00, ' '}, {0x3F, '0'}, {0x06, '1'}, {0x5B, '2'}, {0x4F, '3'}, {0x66, '4'},
+    {0x6D, '5'}, {0x7D, '6'}, {0x07, '7'}, {0x7F, '8'}, {0x6F, '9'}, {0x77, 'A'},
+    {0x5F, 'a'}, {0x7C, 'b'}, {0x39, 'C'}, {0x58, 'c'}, {0x5E, 'd'}, {0x79, 'E'},
+    {0x7B, 'e'}, {0x71, 'F'}, {0x3D, 'G'}, {0x76, 'H'}, {0x74, 'h'}, {0x1E, 'J'},
+    {0x38, 'L'}, {0x37, 'N'}, {0x54, 'n'}, {0x5C, 'o'}, {0x73, 'P'}, {0x50, 'r'},
+    {0x78, 't'}, {0x3E, 'U'}, {0x1C, 'u'}, {0x6E, 'y'}, {0x40, '-'}, {0x08, '_'},
+    {0x63, '*'}, {0x30, 'I'}, {0x10, 'i'}, {0x0C, 'j'}, {0x67, 'q'}
+};
+
+
+/**
+ * @brief Constructor.
+ *
+ * @param address: The device's 7-bit I2C address.
+ */
+HT16K33_Emulator::HT16K33_Emulator(uint8_t address) : Sim::I2CDevice(address) {}
+
+
+/**
+ * @brief The device has been addressed.
+ *
+ * @param isRead: Is the master reading?
+ */
+void HT16K33_Emulator::start(bool isRead) {
+
+    isFirstByte = !isRead;
+    isWritingRAM = false;
+}
+
+
+/**
+ * @brief Receive a byte. The first byte of a write is a command;
+ *        a display address command is followed by RAM data.
+ *
+ * @param byte: The byte.
+ *
+ * @returns `true`: the HT16K33 acknowledges every byte.
+ */
+bool HT16K33_Emulator::write(uint8_t byte) {
+
+    if (isWritingRAM) {
+        ram[pointer] = byte;
+        pointer = (pointer + 1) & 0x0F;
+        return true;
+    }
+
+    if (!isFirstByte) return true;
+    isFirstByte = false;
+
+    switch (byte & 0xF0) {
+        case 0x00:
+            // Display data address pointer
+            pointer = byte & 0x0F;
+            isWritingRAM = true;
+            break;
+        case 0x20:
+            // System setup
+            oscillatorOn = (byte & 0x01) != 0;
+            break;
+        case 0x80:
+            // Display setup
+            displayOn = (byte & 0x01) != 0;
+            blinkRate = (byte >> 1) & 0x03;
+            break;
+        case 0xE0:
+            // Dimming
+            brightness = (byte & 0x0F) + 1;
+            break;
+        default:
+            Sim::count("ht16k33 unknown commands");
+            break;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Send a byte of display RAM to the master.
+ *
+ * @returns The byte.
+ */
+uint8_t HT16K33_Emulator::read(void) {
+
+    const uint8_t byte = ram[pointer];
+    pointer = (pointer + 1) & 0x0F;
+    return byte;
+}
+
+
+/**
+ * @brief The transaction has ended: report what is now shown
+ *        if it differs from before.
+ */
+void HT16K33_Emulator::stop(void) {
+
+    Sim::count("ht16k33 transactions");
+    const std::string now = text();
+    if (now != shown) {
+        shown = now;
+        Sim::count("ht16k33 visible changes");
+
+        char source[16];
+        snprintf(source, sizeof(source), "0x%02X", address());
+        Sim::print(source, "[%s]%s", shown.c_str(), isLit() ? "" : " (off)");
+    }
+}
+
+
+/**
+ * @brief Decode the display RAM into the characters shown: four
+ *        digits, each followed by '.' if its point is lit, with
+ *        ':' between the second and third if the colon is lit.
+ *        Unknown segment patterns show as '?'.
+ *
+ * @returns The display text.
+ */
+std::string HT16K33_Emulator::text(void) const {
+
+    std::string result;
+    for (uint32_t i = 0 ; i < 4 ; ++i) {
+        const uint8_t segments = ram[DIGIT_ROWS[i]] & ~DOT_BIT;
+        char character = '?';
+        for (const auto& glyph : GLYPHS) {
+            if (glyph.segments == segments) {
+                character = glyph.character;
+                break;
+            }
+        }
+
+        result += character;
+        if ((ram[DIGIT_ROWS[i]] & DOT_BIT) != 0) result += '.';
+        if (i == 1) result += (ram[COLON_ROW] & COLON_BIT) != 0 ? ':' : ' ';
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Is the display showing anything?
+ *
+ * @returns `true` if the oscillator and display are both on.
+ */
+bool HT16K33_Emulator::isLit(void) const {
+
+    return oscillatorOn && displayOn;
+}
+
+
+/**
+ * @brief Get the display brightness.
+ *
+ * @returns The brightness, 1-16.
+ */
+uint32_t HT16K33_Emulator::getBrightness(void) const {
+
+    return brightness;
+}
+
+
+/**
+ * @brief Get the display RAM.
+ *
+ * @returns Pointer to the 16 bytes of RAM.
+ */
+const uint8_t* HT16K33_Emulator::getRAM(void) const {
+
+    return ram;
+}
@@ -0,0 +1,54 @@
+/*
+ * Microvisor Clock Demo -- host simulation: HT16K33 emulator
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _HT16K33_EMULATOR_HEADER_
+#define _HT16K33_EMULATOR_HEADER_
+
+
+/*
+ * INCLUDES
+ */
+#include <string>
+#include "sim.h"
+
+
+/**
+    An HT16K33 driving a four-digit, seven-segment display, as wired
+    on the Adafruit 0.56" backpack. It decodes each update of the
+    display RAM into the characters shown and reports visible changes.
+ */
+class HT16K33_Emulator : public Sim::I2CDevice {
+
+    public:
+        explicit            HT16K33_Emulator(uint8_t address = 0x70);
+        // Bus events
+        void                start(bool isRead) override;
+        bool                write(uint8_t byte) override;
+        uint8_t             read(void) override;
+        void                stop(void) override;
+        // Display state
+        std::string         text(void) const;
+        bool                isLit(void) const;
+        uint32_t            getBrightness(void) const;
+        const uint8_t*      getRAM(void) const;
+
+    private:
+        // Properties
+        uint8_t             ram[16] = {0};
+        uint8_t             pointer = 0;
+        bool                isFirstByte = true;
+        bool                isWritingRAM = false;
+        bool                oscillatorOn = false;
+        bool                displayOn = false;
+        uint32_t            blinkRate = 0;
+        uint32_t            brightness = 15;
+        std::string         shown;
+};
+
+
+#endif  // _HT16K33_EMULATOR_HEADER_
@@ -0,0 +1,169 @@
+/*
+ * Microvisor Clock Demo -- host simulation: entry point
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Runs the unmodified app against the simulated MCU, Microvisor and
+ * display, in virtual time, then reports what happened.
+ *
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "sim.h"
+#include "ht16k33_emulator.h"
+#include "civil_time.h"
+
+
+/*
+ * FORWARD DECLARATIONS
+ */
+// The app's `main()`, renamed by the build
+int app_main(void);
+
+
+/**
+ * @brief Show how to run the simulator, then exit.
+ *
+ * @param name: The program name.
+ */
+static void usage(const char* name) {
+
+    printf("Usage: %s [options]\n"
+           "  --start TIME          UTC wall-clock time at boot, as seconds since the\n"
+           "                        epoch or YYYY-MM-DDTHH:MM:SS (default 2024-01-01T00:00:00)\n"
+           "  --seconds N           Virtual seconds to run for (default 60)\n"
+           "  --config KEY=VALUE    Serve VALUE, or the contents of file @VALUE, for config KEY\n"
+           "  --network-delay MS    Time for the network to connect (default 3000)\n"
+           "  --network-drop S      Drop the connection S seconds after boot, then reconnect\n"
+           "  --fetch-delay MS      Config fetch round-trip time (default 400)\n"
+           "  --i2c-hz HZ           I2C bus clock (default 400000)\n"
+           "  --panels N            Display panels on the bus, at 0x70 up, from 1 to 8 (default 1)\n"
+           "  --speed X             Run at X times real time (default: as fast as possible)\n"
+           "  --quiet               Don't show the app's log messages\n", name);
+    exit(1);
+}
+
+
+/**
+ * @brief Parse a boot time given as epoch seconds or as an ISO 8601 date and time.
+ *
+ * @param value: The time string.
+ * @param epoch: Set to the seconds since the epoch.
+ *
+ * @returns `true` if the time is valid, otherwise `false`.
+ */
+static bool parseTime(const char* value, int64_t& epoch) {
+
+    int32_t year;
+    uint32_t month, day, hour, minute, second;
+    if (sscanf(value, "%d-%u-%u%*1[T ]%u:%u:%u", &year, &month, &day, &hour, &minute, &second) == 6) {
+        CivilTime time = {};
+        time.year = year;
+        time.month = month;
+        time.day = day;
+        time.hour = hour;
+        time.minute = minute;
+        time.second = second;
+        epoch = epoch_from_civil_time(&time);
+        return true;
+    }
+
+    char* end = nullptr;
+    epoch = strtoll(value, &end, 10);
+    return end != value && *end == 0;
+}
+
+
+/**
+ * @brief Add a config value, reading it from a file if it starts with '@'.
+ *
+ * @param setting: The KEY=VALUE string.
+ * @param configs: The config store to add to.
+ *
+ * @returns `true` if the value was added, otherwise `false`.
+ */
+static bool addConfig(const char* setting, std::map<std::string, std::string>& configs) {
+
+    const char* equals = strchr(setting, '=');
+    if (equals == nullptr || equals == setting) return false;
+
+    const std::string key(setting, equals - setting);
+    const char* value = equals + 1;
+    if (*value != '@') {
+        configs[key] = value;
+        return true;
+    }
+
+    std::ifstream file(value + 1);
+    if (!file) return false;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    configs[key] = contents.str();
+    return true;
+}
+
+
+/*
+ * RUNTIME START
+ */
+int main(int argc, char* argv[]) {
+
+    Sim::Options options;
+    uint32_t panelCount = 1;
+    for (int i = 1 ; i < argc ; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const bool hasValue = (value != nullptr);
+
+        if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            continue;
+        }
+
+        if (!hasValue) usage(argv[0]);
+        ++i;
+        if (strcmp(arg, "--start") == 0) {
+            if (!parseTime(value, options.startEpoch)) usage(argv[0]);
+        } else if (strcmp(arg, "--seconds") == 0) {
+            options.runSeconds = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--config") == 0) {
+            if (!addConfig(value, options.configs)) usage(argv[0]);
+        } else if (strcmp(arg, "--network-delay") == 0) {
+            options.networkDelayMs = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--network-drop") == 0) {
+            options.networkDropS = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--fetch-delay") == 0) {
+            options.fetchDelayMs = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--i2c-hz") == 0) {
+            options.i2cBitRateHz = (uint32_t)strtoul(value, nullptr, 10);
+            if (options.i2cBitRateHz == 0) usage(argv[0]);
+        } else if (strcmp(arg, "--panels") == 0) {
+            panelCount = (uint32_t)strtoul(value, nullptr, 10);
+            if (panelCount == 0 || panelCount > 8) usage(argv[0]);
+        } else if (strcmp(arg, "--speed") == 0) {
+            options.speed = strtod(value, nullptr);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    Sim::configure(options);
+
+    // Wire up the display panels the app looks for
+    static std::vector<std::unique_ptr<HT16K33_Emulator>> panels;
+    for (uint32_t i = 0 ; i < panelCount ; ++i) {
+        panels.emplace_back(new HT16K33_Emulator((uint8_t)(0x70 + i)));
+        Sim::attach(panels.back().get());
+    }
+
+    // The app never returns: the run ends at its time limit
+    app_main();
+    Sim::finish();
+}
@@ -0,0 +1,326 @@
+/*
+ * Microvisor Clock Demo -- host simulation: Microvisor system call stand-in
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Models the services the app uses: the wall clock, which is set
+ * when the network first connects; the network, which connects
+ * after a configurable delay, and can be made to drop once; config fetch channels, which answer
+ * from the `--config` values; server logging; and the notification
+ * center, which writes records into the app's buffer and raises
+ * its interrupt.
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "mv_syscalls.h"
+
+
+/*
+ * CONSTANTS
+ */
+static constexpr uint32_t       HCLK_HZ = 160000000;
+static constexpr uintptr_t      NOTIFICATION_HANDLE = 0x100;
+static constexpr uintptr_t      FIRST_NETWORK_HANDLE = 0x200;
+static constexpr uintptr_t      FIRST_CHANNEL_HANDLE = 0x300;
+
+
+/*
+ * GLOBALS
+ */
+static bool                     loggingReady = false;
+static bool                     rtcSet = false;
+
+// Notification center
+static MvNotification*          center = nullptr;
+static uint32_t                 centerSize = 0;
+static uint32_t                 centerIndex = 0;
+static IRQn_Type                centerIRQ = 0;
+
+// Network
+static MvNetworkHandle          network = nullptr;
+static MvNetworkStatus          networkStatus = MV_NETWORKSTATUS_DELIBERATELYOFFLINE;
+static uint32_t                 networkTag = 0;
+static uintptr_t                nextNetworkHandle = FIRST_NETWORK_HANDLE;
+static bool                     hasDropped = false;
+
+// Config fetch channel
+static MvChannelHandle          channel = nullptr;
+static uint32_t                 channelTag = 0;
+static uintptr_t                nextChannelHandle = FIRST_CHANNEL_HANDLE;
+static std::vector<std::string> requestedKeys;
+static bool                     responseReady = false;
+
+
+/**
+ * @brief Write a record to the notification center and raise
+ *        its interrupt, as Microvisor does.
+ *
+ * @param type: The event type.
+ * @param tag:  The tag the app supplied for the event's source.
+ */
+static void notify(MvEventType type, uint32_t tag) {
+
+    if (center == nullptr) return;
+
+    MvNotification& record = center[centerIndex];
+    if ((uint32_t)record.event_type != 0 && (uint32_t)record.event_type != 0xFFFFFFFF) Sim::count("notifications overwritten");
+    record.microseconds = Sim::now();
+    record.event_type = type;
+    record.tag = tag;
+    centerIndex = (centerIndex + 1) % centerSize;
+
+    Sim::count("notifications");
+    Sim::raise(centerIRQ);
+}
+
+
+extern "C" {
+
+/*
+ * TIME AND DEVICE
+ */
+enum MvStatus mvGetWallTime(uint64_t* usec) {
+
+    // The RTC is zero until the device has been online
+    *usec = rtcSet ? Sim::wallTime() : 0;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvGetMicroseconds(uint64_t* usec) {
+
+    *usec = Sim::now();
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvGetHClk(uint32_t* hz) {
+
+    *hz = HCLK_HZ;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvGetPClk1(uint32_t* hz) {
+
+    *hz = HCLK_HZ;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvGetDeviceId(uint8_t* buffer, uint32_t length) {
+
+    static const char DEVICE_ID[] = "UVSIMULATED000000000000000000000000";
+    memcpy(buffer, DEVICE_ID, length < sizeof(DEVICE_ID) ? length : sizeof(DEVICE_ID));
+    return MV_STATUS_OKAY;
+}
+
+
+/*
+ * LOGGING
+ */
+enum MvStatus mvServerLoggingInit([[maybe_unused]] uint8_t* buffer, [[maybe_unused]] uint32_t length) {
+
+    loggingReady = true;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvServerLog(const uint8_t* text, uint16_t length) {
+
+    if (!loggingReady) return MV_STATUS_UNAVAILABLE;
+
+    Sim::count("log messages");
+    Sim::count("log bytes", length);
+    if (!Sim::options().quiet) Sim::print("log", "%.*s", (int)length, (const char*)text);
+    return MV_STATUS_OKAY;
+}
+
+
+/*
+ * NOTIFICATIONS
+ */
+enum MvStatus mvSetupNotifications(const struct MvNotificationSetup* setup, MvNotificationHandle* handle) {
+
+    if (setup->buffer == nullptr || setup->buffer_size < sizeof(MvNotification)) return MV_STATUS_PARAMETERFAULT;
+
+    center = setup->buffer;
+    centerSize = setup->buffer_size / sizeof(MvNotification);
+    centerIndex = 0;
+    centerIRQ = (IRQn_Type)setup->irq;
+    *handle = (MvNotificationHandle)NOTIFICATION_HANDLE;
+    return MV_STATUS_OKAY;
+}
+
+
+/*
+ * NETWORK
+ */
+/**
+ * @brief Schedule the connection's drop, if one is set for later,
+ *        and its reconnection after the connect delay.
+ *
+ * @param connected: The network handle that is connected.
+ */
+static void scheduleDrop(MvNetworkHandle connected) {
+
+    const uint64_t dropUs = (uint64_t)Sim::options().networkDropS * 1000000;
+    if (hasDropped || dropUs == 0) return;
+
+    hasDropped = true;
+    Sim::at(dropUs, [connected]() {
+        if (network != connected) return;
+        networkStatus = MV_NETWORKSTATUS_CONNECTING;
+        Sim::print("network", "connection lost");
+        notify(MV_EVENTTYPE_NETWORKSTATUSCHANGED, networkTag);
+
+        Sim::at(Sim::now() + (uint64_t)Sim::options().networkDelayMs * 1000, [connected]() {
+            if (network != connected) return;
+            networkStatus = MV_NETWORKSTATUS_CONNECTED;
+            Sim::print("network", "connected");
+            notify(MV_EVENTTYPE_NETWORKSTATUSCHANGED, networkTag);
+        });
+    });
+}
+
+
+enum MvStatus mvRequestNetwork(struct MvRequestNetworkParams* params, MvNetworkHandle* handle) {
+
+    if (params->version != 1 || params->v1.notification_handle != (MvNotificationHandle)NOTIFICATION_HANDLE) return MV_STATUS_PARAMETERFAULT;
+
+    network = (MvNetworkHandle)nextNetworkHandle++;
+    networkStatus = MV_NETWORKSTATUS_CONNECTING;
+    networkTag = params->v1.notification_tag;
+    *handle = network;
+    Sim::print("network", "connecting");
+
+    // Come online after the configured delay, unless released first
+    const MvNetworkHandle requested = network;
+    Sim::at(Sim::now() + (uint64_t)Sim::options().networkDelayMs * 1000, [requested]() {
+        if (network != requested) return;
+        networkStatus = MV_NETWORKSTATUS_CONNECTED;
+        rtcSet = true;
+        Sim::print("network", "connected");
+        notify(MV_EVENTTYPE_NETWORKSTATUSCHANGED, networkTag);
+        scheduleDrop(requested);
+    });
+
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvReleaseNetwork(MvNetworkHandle* handle) {
+
+    if (*handle != network || network == nullptr) return MV_STATUS_INVALIDHANDLE;
+
+    network = nullptr;
+    networkStatus = MV_NETWORKSTATUS_DELIBERATELYOFFLINE;
+    *handle = nullptr;
+    Sim::print("network", "released");
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvGetNetworkStatus(MvNetworkHandle handle, enum MvNetworkStatus* status) {
+
+    if (handle != network || network == nullptr) return MV_STATUS_INVALIDHANDLE;
+
+    *status = networkStatus;
+    return MV_STATUS_OKAY;
+}
+
+
+/*
+ * CONFIG FETCH CHANNELS
+ */
+enum MvStatus mvOpenChannel(const struct MvOpenChannelParams* params, MvChannelHandle* handle) {
+
+    if (params->version != 1 || params->v1.channel_type != MV_CHANNELTYPE_CONFIGFETCH) return MV_STATUS_PARAMETERFAULT;
+    if (params->v1.network_handle != network || networkStatus != MV_NETWORKSTATUS_CONNECTED) return MV_STATUS_UNAVAILABLE;
+    if (channel != nullptr) return MV_STATUS_UNAVAILABLE;
+
+    channel = (MvChannelHandle)nextChannelHandle++;
+    channelTag = params->v1.notification_tag;
+    responseReady = false;
+    *handle = channel;
+    Sim::count("channels opened");
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvCloseChannel(MvChannelHandle* handle) {
+
+    if (*handle != channel || channel == nullptr) return MV_STATUS_INVALIDHANDLE;
+
+    channel = nullptr;
+    requestedKeys.clear();
+    responseReady = false;
+    *handle = nullptr;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvSendConfigFetchRequest(MvChannelHandle handle, const struct MvConfigKeyFetchParams* request) {
+
+    if (handle != channel || channel == nullptr) return MV_STATUS_INVALIDHANDLE;
+    if (request->num_items == 0 || request->keys_to_fetch == nullptr) return MV_STATUS_PARAMETERFAULT;
+
+    requestedKeys.clear();
+    for (uint32_t i = 0 ; i < request->num_items ; ++i) {
+        const MvSizedString& key = request->keys_to_fetch[i].key;
+        requestedKeys.emplace_back((const char*)key.data, key.length);
+    }
+
+    // Answer after the configured server round-trip time
+    Sim::count("config fetches");
+    const MvChannelHandle requested = channel;
+    Sim::at(Sim::now() + (uint64_t)Sim::options().fetchDelayMs * 1000, [requested]() {
+        if (channel != requested) return;
+        responseReady = true;
+        notify(MV_EVENTTYPE_CHANNELDATAREADABLE, channelTag);
+    });
+
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvReadConfigFetchResponseData(MvChannelHandle handle, struct MvConfigResponseData* response) {
+
+    if (handle != channel || channel == nullptr) return MV_STATUS_INVALIDHANDLE;
+    if (!responseReady) return MV_STATUS_UNAVAILABLE;
+
+    response->result = MV_CONFIGFETCHRESULT_OK;
+    response->num_items = (uint32_t)requestedKeys.size();
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvReadConfigResponseItem(MvChannelHandle handle, const struct MvConfigResponseReadItemParams* item) {
+
+    if (handle != channel || channel == nullptr) return MV_STATUS_INVALIDHANDLE;
+    if (!responseReady || item->item_index >= requestedKeys.size()) return MV_STATUS_PARAMETERFAULT;
+
+    const auto& configs = Sim::options().configs;
+    const auto entry = configs.find(requestedKeys[item->item_index]);
+    if (entry == configs.end()) {
+        *item->result = MV_CONFIGKEYFETCHRESULT_KEYNOTFOUND;
+        *item->buf.length = 0;
+        return MV_STATUS_OKAY;
+    }
+
+    const std::string& value = entry->second;
+    const uint32_t length = value.size() < item->buf.size ? (uint32_t)value.size() : item->buf.size;
+    memcpy(item->buf.data, value.data(), length);
+    *item->buf.length = length;
+    *item->result = MV_CONFIGKEYFETCHRESULT_OK;
+    return MV_STATUS_OKAY;
+}
+
+
+}   // extern "C"
@@ -0,0 +1,374 @@
+/*
+ * Microvisor Clock Demo -- host simulation core
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * A single-threaded model of the parts of the MCU the app relies on:
+ * a virtual microsecond clock, a queue of timed events, and an
+ * interrupt controller whose handlers run when the app sleeps in
+ * WFI, delays, or re-enables interrupts -- as they would on the
+ * device, where they pre-empt the main loop.
+ *
+ */
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include "sim.h"
+#include "civil_time.h"
+
+
+/*
+ * FORWARD DECLARATIONS
+ */
+// The app's interrupt handlers
+extern "C" {
+    void TIM8_BRK_IRQHandler(void);
+    void I2C1_EV_IRQHandler(void);
+    void I2C1_ER_IRQHandler(void);
+    void GPDMA1_Channel0_IRQHandler(void);
+    void USART2_IRQHandler(void);
+}
+
+
+/*
+ * GLOBALS
+ */
+static Sim::Options                                         settings;
+static uint64_t                                             nowUs = 0;
+static uint64_t                                             eventOrder = 0;
+// Keyed by time, then by order of scheduling, so simultaneous events run in turn
+static std::map<std::pair<uint64_t, uint64_t>, std::function<void(void)>> events;
+
+static std::set<IRQn_Type>                                  pendingIRQs;
+static std::set<IRQn_Type>                                  enabledIRQs;
+static uint32_t                                             primaskValue = 0;
+static bool                                                 inHandler = false;
+
+static std::map<uint8_t, Sim::I2CDevice*>                   i2cDevices;
+static std::map<std::string, uint64_t>                      counters;
+static const auto                                           realStart = std::chrono::steady_clock::now();
+
+
+/**
+ * @brief Run the handlers of every pending, enabled interrupt,
+ *        unless interrupts are masked or a handler is running.
+ */
+static void serviceInterrupts(void) {
+
+    if (primaskValue != 0 || inHandler) return;
+
+    inHandler = true;
+    bool serviced = true;
+    while (serviced) {
+        serviced = false;
+        for (const IRQn_Type irq : pendingIRQs) {
+            if (enabledIRQs.count(irq) == 0) continue;
+
+            // Lower IRQ numbers first, re-checking after each
+            // handler as it may raise further interrupts
+            pendingIRQs.erase(irq);
+            Sim::count("interrupts");
+            switch (irq) {
+                case TIM8_BRK_IRQn:         TIM8_BRK_IRQHandler();          break;
+                case I2C1_EV_IRQn:          I2C1_EV_IRQHandler();           break;
+                case I2C1_ER_IRQn:          I2C1_ER_IRQHandler();           break;
+                case GPDMA1_Channel0_IRQn:  GPDMA1_Channel0_IRQHandler();   break;
+                case USART2_IRQn:           USART2_IRQHandler();            break;
+                default:                                                    break;
+            }
+
+            serviced = true;
+            break;
+        }
+    }
+
+    inHandler = false;
+}
+
+
+/**
+ * @brief Move virtual time forward to the specified instant, running
+ *        every event due by then. Ends the run at its time limit.
+ *
+ * @param targetUs: The new virtual time.
+ */
+static void advanceTo(uint64_t targetUs) {
+
+    const uint64_t limitUs = (uint64_t)settings.runSeconds * 1000000;
+
+    while (!events.empty() && events.begin()->first.first <= targetUs) {
+        auto next = events.begin();
+        nowUs = next->first.first;
+        if (nowUs >= limitUs) Sim::finish();
+        auto action = std::move(next->second);
+        events.erase(next);
+        action();
+    }
+
+    nowUs = targetUs;
+    if (nowUs >= limitUs) Sim::finish();
+
+    // Optionally pace the run against real time
+    if (settings.speed > 0.0) {
+        const auto due = realStart + std::chrono::microseconds((uint64_t)((double)nowUs / settings.speed));
+        std::this_thread::sleep_until(due);
+    }
+}
+
+
+namespace Sim {
+
+/**
+ * @brief Apply the run settings. Call before starting the app.
+ *
+ * @param options: The settings.
+ */
+void configure(const Options& options) {
+
+    settings = options;
+}
+
+
+/**
+ * @brief Get the run settings.
+ *
+ * @returns The settings.
+ */
+const Options& options(void) {
+
+    return settings;
+}
+
+
+/**
+ * @brief Get the virtual time since boot.
+ *
+ * @returns The time in microseconds.
+ */
+uint64_t now(void) {
+
+    return nowUs;
+}
+
+
+/**
+ * @brief Get the virtual UTC wall-clock time.
+ *
+ * @returns Microseconds since the Unix epoch.
+ */
+uint64_t wallTime(void) {
+
+    return (uint64_t)settings.startEpoch * 1000000 + nowUs;
+}
+
+
+/**
+ * @brief Schedule an action at a point in virtual time.
+ *
+ * @param timeUs: When to perform the action.
+ * @param action: The action, typically one that raises an interrupt.
+ */
+void at(uint64_t timeUs, std::function<void(void)> action) {
+
+    if (timeUs < nowUs) timeUs = nowUs;
+    events.emplace(std::make_pair(timeUs, eventOrder++), std::move(action));
+}
+
+
+/**
+ * @brief Let a period of virtual time pass, with interrupts
+ *        taken as they arrive, as during a busy-wait.
+ *
+ * @param periodUs: The period.
+ */
+void advance(uint64_t periodUs) {
+
+    const uint64_t targetUs = nowUs + periodUs;
+    while (nowUs < targetUs) {
+        uint64_t stepUs = targetUs;
+        if (!events.empty() && events.begin()->first.first < stepUs) stepUs = events.begin()->first.first;
+        advanceTo(stepUs);
+        serviceInterrupts();
+    }
+}
+
+
+/**
+ * @brief Sleep until the next interrupt. The 1ms HAL tick always
+ *        wakes the core, so this never sleeps beyond a tick boundary.
+ */
+void waitForInterrupt(void) {
+
+    count("wfi");
+    for (const IRQn_Type irq : pendingIRQs) {
+        if (enabledIRQs.count(irq) != 0) {
+            serviceInterrupts();
+            return;
+        }
+    }
+
+    uint64_t wakeUs = (nowUs / 1000 + 1) * 1000;
+    if (!events.empty() && events.begin()->first.first < wakeUs) wakeUs = events.begin()->first.first;
+    advanceTo(wakeUs);
+    serviceInterrupts();
+}
+
+
+/**
+ * @brief Flag an interrupt as pending.
+ *
+ * @param irq: The interrupt.
+ */
+void raise(IRQn_Type irq) {
+
+    pendingIRQs.insert(irq);
+}
+
+
+/**
+ * @brief Allow an interrupt to be taken.
+ *
+ * @param irq: The interrupt.
+ */
+void enable(IRQn_Type irq) {
+
+    enabledIRQs.insert(irq);
+}
+
+
+/**
+ * @brief Drop a pending interrupt.
+ *
+ * @param irq: The interrupt.
+ */
+void clearPending(IRQn_Type irq) {
+
+    pendingIRQs.erase(irq);
+}
+
+
+/**
+ * @brief Get the interrupt mask.
+ *
+ * @returns 1 if interrupts are disabled, otherwise 0.
+ */
+uint32_t primask(void) {
+
+    return primaskValue;
+}
+
+
+/**
+ * @brief Set the interrupt mask. Unmasking takes any pending
+ *        interrupts at once, as the core would.
+ *
+ * @param mask: 1 to disable interrupts, 0 to enable them.
+ */
+void setPrimask(uint32_t mask) {
+
+    primaskValue = mask;
+    if (mask == 0) serviceInterrupts();
+}
+
+
+/**
+ * @brief Connect a peripheral to the I2C bus.
+ *
+ * @param device: The peripheral. It must outlive the run.
+ */
+void attach(I2CDevice* device) {
+
+    i2cDevices[device->address()] = device;
+}
+
+
+/**
+ * @brief Find the peripheral that responds to an address.
+ *
+ * @param address: The 7-bit I2C address.
+ *
+ * @returns The device, or `nullptr` if none is attached there.
+ */
+I2CDevice* device(uint8_t address) {
+
+    auto entry = i2cDevices.find(address);
+    return entry != i2cDevices.end() ? entry->second : nullptr;
+}
+
+
+/**
+ * @brief Get the bus time to address a device and move some bytes,
+ *        counting nine clocks per byte.
+ *
+ * @param byteCount: The number of data bytes.
+ *
+ * @returns The time in microseconds, at least 1.
+ */
+uint64_t i2cTransferTime(uint32_t byteCount) {
+
+    const uint64_t bits = (uint64_t)(byteCount + 1) * 9;
+    const uint64_t timeUs = (bits * 1000000) / settings.i2cBitRateHz;
+    return timeUs > 0 ? timeUs : 1;
+}
+
+
+/**
+ * @brief Print a line of simulator output, stamped with
+ *        the virtual wall-clock time.
+ *
+ * @param source: The part of the simulation producing the output.
+ * @param format: The message, with optional formatting.
+ */
+void print(const char* source, const char* format, ...) {
+
+    if (settings.silent) return;
+
+    char timestamp[CIVIL_TIMESTAMP_LEN + 1] = {0};
+    const uint64_t wall = wallTime();
+    const CivilTime time = civil_time_from_epoch((int64_t)(wall / 1000000));
+    civil_time_format(&time, timestamp);
+
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    printf("%s.%03u %-8s %s\n", timestamp, (unsigned)((wall / 1000) % 1000), source, message);
+}
+
+
+/**
+ * @brief Add to a named statistic, reported when the run ends.
+ *
+ * @param counter: The statistic's name.
+ * @param amount:  The amount to add.
+ */
+void count(const std::string& counter, uint64_t amount) {
+
+    counters[counter] += amount;
+}
+
+
+/**
+ * @brief End the run, reporting the statistics.
+ */
+void finish(void) {
+
+    const double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+    printf("\nSimulated %us in %.3fs\n", settings.runSeconds, realSeconds);
+    for (const auto& [name, value] : counters) {
+        printf("  %-24s %llu\n", name.c_str(), (unsigned long long)value);
+    }
+
+    fflush(stdout);
+    std::exit(0);
+}
+
+
+}   // namespace Sim
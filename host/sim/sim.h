@@ -0,0 +1,97 @@
+/*
+ * Microvisor Clock Demo -- host simulation core
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ */
+#ifndef _SIM_HEADER_
+#define _SIM_HEADER_
+
+
+/*
+ * INCLUDES
+ */
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include "stm32u5xx_hal.h"
+
+
+/*
+ * STRUCTURES
+ */
+namespace Sim {
+
+    // Run settings, set from the command line
+    typedef struct {
+        int64_t                             startEpoch = 1704067200;    // 2024-01-01 00:00:00 UTC
+        uint32_t                            runSeconds = 60;
+        uint32_t                            networkDelayMs = 3000;
+        uint32_t                            networkDropS = 0;           // When the connection drops, once. 0 = never
+        uint32_t                            fetchDelayMs = 400;
+        uint32_t                            i2cBitRateHz = 400000;
+        double                              speed = 0.0;                // 0 = as fast as possible
+        bool                                quiet = false;              // Don't echo app log messages
+        bool                                silent = false;             // Print nothing, eg. when benchmarking
+        std::map<std::string, std::string>  configs;                    // Config key -> value
+    } Options;
+
+
+    /**
+        An I2C peripheral attached to the simulated bus.
+     */
+    class I2CDevice {
+
+        public:
+            explicit            I2CDevice(uint8_t address) : busAddress(address) {}
+            virtual             ~I2CDevice() = default;
+            uint8_t             address(void) const { return busAddress; }
+            // Bus events, in transaction order
+            virtual void        start(bool isRead) = 0;
+            virtual bool        write(uint8_t byte) = 0;
+            virtual uint8_t     read(void) = 0;
+            virtual void        stop(void) = 0;
+            // Time the device holds SCL low for, in each frame
+            virtual uint64_t    stretchTime(void) { return 0; }
+
+        private:
+            uint8_t             busAddress;
+    };
+
+
+    /*
+     * PROTOTYPES
+     */
+    void                configure(const Options& settings);
+    const Options&      options(void);
+
+    // Virtual time
+    uint64_t            now(void);
+    uint64_t            wallTime(void);
+    void                at(uint64_t timeUs, std::function<void(void)> action);
+    void                advance(uint64_t periodUs);
+    void                waitForInterrupt(void);
+
+    // Interrupt controller
+    void                raise(IRQn_Type irq);
+    void                enable(IRQn_Type irq);
+    void                clearPending(IRQn_Type irq);
+    uint32_t            primask(void);
+    void                setPrimask(uint32_t mask);
+
+    // I2C bus
+    void                attach(I2CDevice* device);
+    I2CDevice*          device(uint8_t address);
+    uint64_t            i2cTransferTime(uint32_t byteCount);
+
+    // Output and statistics
+    void                print(const char* source, const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void                count(const std::string& counter, uint64_t amount = 1);
+    [[noreturn]] void   finish(void);
+}
+
+
+#endif  // _SIM_HEADER_
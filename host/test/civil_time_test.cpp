@@ -0,0 +1,112 @@
+/*
+ * Microvisor Clock Demo -- civil time conversion tests
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Checks the integer-only conversions in civil_time.h against glibc's
+ * gmtime_r(), timegm() and strftime() over 1970 to 2100: the first and
+ * last second of every day, and every 61st second in between, which
+ * steps through every time of day over the range.
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include "civil_time.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr int64_t   FIRST_SECOND = 0;                   // 1970-01-01 00:00:00 UTC
+constexpr int64_t   LAST_SECOND = 4133980799;           // 2100-12-31 23:59:59 UTC
+constexpr int64_t   STEP_SECONDS = 61;
+constexpr uint32_t  MAX_REPORTS = 20;
+
+// The conversions are usable at compile time
+static_assert(days_from_civil(2024, 2, 29) == 19782, "Bad days_from_civil()");
+static_assert(weekday_from_days(19782) == 4, "Bad weekday_from_days()");
+static_assert(civil_time_from_epoch(951782400).day == 29, "Bad civil_time_from_epoch()");
+
+
+/*
+ * GLOBALS
+ */
+static uint64_t checks = 0;
+static uint64_t failures = 0;
+
+
+/**
+ * @brief Compare one instant's conversions with glibc's.
+ *
+ * @param secs: Seconds since 1970-01-01 00:00:00 UTC.
+ * @param doFormat: `true` to check the timestamp formatting too.
+ */
+static void check(int64_t secs, bool doFormat) {
+
+    const time_t t = (time_t)secs;
+    struct tm expected;
+    gmtime_r(&t, &expected);
+
+    const CivilTime actual = civil_time_from_epoch(secs);
+    bool isGood = actual.year == expected.tm_year + 1900
+                  && actual.month == (uint32_t)expected.tm_mon + 1
+                  && actual.day == (uint32_t)expected.tm_mday
+                  && actual.hour == (uint32_t)expected.tm_hour
+                  && actual.minute == (uint32_t)expected.tm_min
+                  && actual.second == (uint32_t)expected.tm_sec
+                  && actual.weekday == (uint32_t)expected.tm_wday
+                  && epoch_from_civil_time(&actual) == secs
+                  && epoch_from_civil_time(&actual) == (int64_t)timegm(&expected);
+
+    if (doFormat) {
+        char wanted[CIVIL_TIMESTAMP_LEN + 1] = {0};
+        char written[CIVIL_TIMESTAMP_LEN + 1] = {0};
+        strftime(wanted, sizeof(wanted), "%Y-%m-%d %H:%M:%S", &expected);
+        civil_time_format(&actual, written);
+        isGood = isGood && strcmp(wanted, written) == 0;
+    }
+
+    checks++;
+    if (!isGood) {
+        if (failures < MAX_REPORTS) {
+            printf("FAIL %lld: got %04d-%02u-%02u %02u:%02u:%02u day %u, expected %04d-%02d-%02d %02d:%02d:%02d day %d\n",
+                   (long long)secs, actual.year, actual.month, actual.day, actual.hour, actual.minute, actual.second, actual.weekday,
+                   expected.tm_year + 1900, expected.tm_mon + 1, expected.tm_mday, expected.tm_hour, expected.tm_min, expected.tm_sec, expected.tm_wday);
+        }
+
+        failures++;
+    }
+}
+
+
+int main(void) {
+
+    // The ends of every day
+    for (int64_t day = FIRST_SECOND ; day <= LAST_SECOND ; day += CIVIL_SECONDS_PER_DAY) {
+        check(day, true);
+        check(day + CIVIL_SECONDS_PER_DAY - 1, true);
+    }
+
+    // Every time of day, spread across the range
+    for (int64_t secs = FIRST_SECOND ; secs <= LAST_SECOND ; secs += STEP_SECONDS) {
+        check(secs, false);
+    }
+
+    // Every day count maps back to itself
+    for (int32_t days = 0 ; days <= LAST_SECOND / CIVIL_SECONDS_PER_DAY ; ++days) {
+        int32_t year = 0;
+        uint32_t month = 0, day = 0;
+        civil_from_days(days, &year, &month, &day);
+        checks++;
+        if (days_from_civil(year, month, day) != days) {
+            if (failures < MAX_REPORTS) printf("FAIL day %d: round trip gives %d\n", days, days_from_civil(year, month, day));
+            failures++;
+        }
+    }
+
+    printf("civil_time: %llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * Microvisor Clock Demo -- display group tests
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Checks DisplayGroup::draw() on the simulated bus when one panel of
+ * the group stops acknowledging its writes: the panels after it in the
+ * shared transaction must still be updated, the panels must go back to
+ * sharing one transaction, and the failed panel must be brought up to
+ * date once it answers again.
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include "main.h"
+#include "ht16k33_emulator.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint32_t  PANEL_COUNT = 4;
+constexpr uint32_t  FAULTY_PANEL = 0;          // The first, so others share its transactions
+constexpr uint32_t  FLUSH_TIMEOUT_MS = 10;
+
+
+/**
+    An HT16K33 which can be made to NACK the bytes written to it.
+ */
+class FaultyEmulator : public HT16K33_Emulator {
+
+    public:
+        explicit            FaultyEmulator(uint8_t address) : HT16K33_Emulator(address) {}
+        bool                write(uint8_t byte) override { return !isNacking && HT16K33_Emulator::write(byte); }
+
+        bool                isNacking = false;
+};
+
+
+/*
+ * GLOBALS
+ */
+static FaultyEmulator   emulators[PANEL_COUNT] = {
+    FaultyEmulator(0x70), FaultyEmulator(0x71), FaultyEmulator(0x72), FaultyEmulator(0x73)
+};
+
+static DisplayGroup     group;
+static uint64_t         checks = 0;
+static uint64_t         failures = 0;
+
+
+/**
+ * @brief Record the outcome of one check.
+ *
+ * @param isGood: Did the check pass?
+ * @param what:   Description of the check.
+ */
+static void check(bool isGood, const char* what) {
+
+    checks++;
+    if (!isGood) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+
+/**
+ * @brief Show a different four-digit number on every panel,
+ *        draw the group, and wait for the bus to finish.
+ *
+ * @param base: The first panel's number.
+ */
+static void drawNumbers(uint32_t base) {
+
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) {
+        char text[8];
+        snprintf(text, sizeof(text), "%04lu", (unsigned long)(base + i));
+        group.panel(i).setText(text);
+    }
+
+    group.draw();
+    I2C::flush(FLUSH_TIMEOUT_MS);
+}
+
+
+/**
+ * @brief Check whether a panel shows the number `drawNumbers()` gave it.
+ *
+ * @param index: The panel's index.
+ * @param base:  The first panel's number.
+ *
+ * @returns `true` if it does, otherwise `false`.
+ */
+static bool shows(uint32_t index, uint32_t base) {
+
+    // The emulator shows the colon, which is off, between the digit pairs
+    const uint32_t number = base + index;
+    char text[8];
+    snprintf(text, sizeof(text), "%02lu %02lu", (unsigned long)(number / 100), (unsigned long)(number % 100));
+    return emulators[index].text() == text;
+}
+
+
+int main(void) {
+
+    Sim::Options options;
+    options.runSeconds = 3600;
+    options.silent = true;
+    Sim::configure(options);
+    for (auto& emulator : emulators) Sim::attach(&emulator);
+    I2C::setup();
+
+    group.init();
+    check(group.size() == PANEL_COUNT, "panels not all found");
+
+    drawNumbers(1000);
+    bool isGood = true;
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) isGood = isGood && shows(i, 1000);
+    check(isGood, "panels not drawn");
+
+    // One panel stops answering. The others are brought up to date by
+    // the next draw at the latest, and stay up to date
+    emulators[FAULTY_PANEL].isNacking = true;
+    drawNumbers(2000);
+    drawNumbers(3000);
+    isGood = true;
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) isGood = isGood && (i == FAULTY_PANEL || shows(i, 3000));
+    check(isGood, "panels behind a failing panel not drawn");
+
+    drawNumbers(4000);
+    isGood = true;
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) isGood = isGood && (i == FAULTY_PANEL || shows(i, 4000));
+    check(isGood, "panels behind a failing panel not kept up to date");
+    check(shows(FAULTY_PANEL, 1000), "failing panel changed");
+
+    // The working panels share one transaction, the failing panel has its own
+    uint32_t transactions = group.getTransactions();
+    drawNumbers(5000);
+    check(group.getTransactions() - transactions == 2, "working panels not batched apart from the failing one");
+
+    // Once the panel answers again, it is redrawn and rejoins the batch
+    emulators[FAULTY_PANEL].isNacking = false;
+    drawNumbers(6000);
+    isGood = true;
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) isGood = isGood && shows(i, 6000);
+    check(isGood, "panels not drawn after recovery");
+
+    transactions = group.getTransactions();
+    drawNumbers(7000);
+    isGood = true;
+    for (uint32_t i = 0 ; i < PANEL_COUNT ; ++i) isGood = isGood && shows(i, 7000);
+    check(isGood, "panels not kept up to date after recovery");
+    check(group.getTransactions() - transactions == 1, "panels not batched after recovery");
+
+    printf("display_group: %llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
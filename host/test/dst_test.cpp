@@ -0,0 +1,190 @@
+/*
+ * Microvisor Clock Demo -- POSIX TZ and DST tests
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Checks DST::parseTZ() and DST::Zone against glibc's localtime_r(),
+ * which is given the same TZ string. Each zone is sampled hourly from
+ * 2024 to 2100, and at the second either side of each of its DST
+ * transitions. The zones are the distinct POSIX footers of the IANA
+ * tz database, plus hand-written edge cases. It also checks that zones
+ * without DST rules get the US rules, and that bad strings are refused.
+ *
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr int64_t   FIRST_SECOND = 1704067200;          // 2024-01-01 00:00:00 UTC
+constexpr int64_t   LAST_SECOND = 4133980799;           // 2100-12-31 23:59:59 UTC
+constexpr int32_t   FIRST_YEAR = 2024;
+constexpr int32_t   LAST_YEAR = 2100;
+constexpr uint32_t  MAX_REPORTS = 20;
+
+// The footers of the tz database's zone files (tzdata 2024)
+static const char* const ZONES[] = {
+    "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3", "<+01>-1", "<+02>-2", "<+0330>-3:30", "<+03>-3",
+    "<+0430>-4:30", "<+04>-4", "<+0530>-5:30", "<+0545>-5:45", "<+05>-5", "<+0630>-6:30",
+    "<+06>-6", "<+07>-7", "<+0845>-8:45", "<+08>-8", "<+09>-9",
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0", "<+10>-10", "<+11>-11",
+    "<+11>-11<+12>,M10.1.0,M4.1.0/3", "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45",
+    "<+12>-12", "<+13>-13", "<+14>-14", "<-00>0", "<-01>1", "<-01>1<+00>,M3.5.0/0,M10.5.0/1",
+    "<-02>2", "<-02>2<-01>,M3.5.0/-1,M10.5.0/0", "<-03>3", "<-03>3<-02>,M3.2.0,M11.1.0",
+    "<-04>4", "<-04>4<-03>,M9.1.6/24,M4.1.6/24", "<-05>5", "<-06>6",
+    "<-06>6<-05>,M9.1.6/22,M4.1.6/22", "<-07>7", "<-08>8", "<-0930>9:30", "<-09>9",
+    "<-10>10", "<-11>11", "<-12>12", "ACST-9:30", "ACST-9:30ACDT,M10.1.0,M4.1.0/3", "AEST-10",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3", "AKST9AKDT,M3.2.0,M11.1.0", "AST4", "AST4ADT,M3.2.0,M11.1.0",
+    "AWST-8", "CAT-2", "CET-1", "CET-1CEST,M3.5.0,M10.5.0/3", "CST-8", "CST5CDT,M3.2.0/0,M11.1.0/1",
+    "CST6", "CST6CDT,M3.2.0,M11.1.0", "ChST-10", "EAT-3", "EET-2", "EET-2EEST,M3.4.4/50,M10.4.4/50",
+    "EET-2EEST,M3.5.0,M10.5.0/3", "EET-2EEST,M3.5.0/0,M10.5.0/0", "EET-2EEST,M3.5.0/3,M10.5.0/4",
+    "EET-2EEST,M4.5.5/0,M10.5.4/24", "EST5", "EST5EDT,M3.2.0,M11.1.0", "GMT0",
+    "GMT0BST,M3.5.0/1,M10.5.0", "HKT-8", "HST10", "HST10HDT,M3.2.0,M11.1.0",
+    "IST-1GMT0,M10.5.0,M3.5.0/1", "IST-2IDT,M3.4.4/26,M10.5.0", "IST-5:30", "JST-9", "KST-9",
+    "MET-1MEST,M3.5.0,M10.5.0/3", "MSK-3", "MST7", "MST7MDT,M3.2.0,M11.1.0",
+    "NST3:30NDT,M3.2.0,M11.1.0", "NZST-12NZDT,M9.5.0,M4.1.0/3", "PKT-5", "PST-8",
+    "PST8PDT,M3.2.0,M11.1.0", "SAST-2", "SST11", "UTC0", "WAT-1", "WET0WEST,M3.5.0/1,M10.5.0",
+    "WIB-7", "WIT-9", "WITA-8",
+
+    // Edge cases. glibc works out each year's changes on their own, so
+    // these keep clear of changes that fall in another year in UTC
+    "AAA3BBB,J60/2,J300/2",                     // Julian days, Feb 29 not counted
+    "AAA3BBB,59/2,299/2",                       // Zero-based days, Feb 29 counted
+    "AAA3BBB,1/0,364/20",                       // Near the ends of the year, by day number
+    "AAA-1:00:30BBB-2:00:30,M3.5.0,M10.5.0",    // Offsets with seconds
+    "AAA+5BBB+4,M3.2.0/-1:30,M11.1.0/26",       // Explicit sign, negative and >24h times
+    "AAA5BBB3,M3.2.0,M11.1.0",                  // A two-hour DST shift
+    "AAA4BBB,M1.1.0/2,M12.5.6/2",               // Near the ends of the year, by weekday
+    "AAA-13BBB-14,M9.5.0/2,M4.1.0/3",           // Southern hemisphere, across the date line
+    "AAA3BBB,M2.5.4,M10.5.3/167",               // Feb 29 as the last Thursday; the longest time
+    "<UTC+5>-5<UTC+6>,M3.2.0,M11.1.0"           // Names with signs and digits
+};
+
+// DST without rules follows the US rules. glibc takes these from its
+// 'posixrules' file instead, so they are checked against the US rules
+static const char* const RULELESS_ZONES[][2] = {
+    { "EST5EDT",            "EST5EDT,M3.2.0,M11.1.0" },
+    { "<UTC+5>-5<UTC+6>",   "<UTC+5>-5<UTC+6>,M3.2.0,M11.1.0" },
+    { "AAA3BBB1",           "AAA3BBB1,M3.2.0,M11.1.0" }
+};
+
+static const char* const INVALID_ZONES[] = {
+    "", "AB3", "AAA", "<+03-3", "<+3>-3", "AAA3BBB,M13.1.0,M10.5.0", "AAA3BBB,M3.6.0,M10.5.0",
+    "AAA3BBB,M3.5.7,M10.5.0", "AAA3BBB,J0,J300", "AAA3BBB,366,300", "AAA3BBB,M3.5.0",
+    "AAA3BBB,M3.5.0,M10.5.0/168", "AAA3:60", "AAA3BBB,M3.5.0,M10.5.0x"
+};
+
+
+/*
+ * GLOBALS
+ */
+static uint64_t checks = 0;
+static uint64_t failures = 0;
+
+
+/**
+ * @brief Compare the zone's offset and DST state at one instant with glibc's.
+ *
+ * @param tz:   The zone's TZ string, which glibc is already using.
+ * @param zone: The zone.
+ * @param utc:  Time in epoch seconds.
+ */
+static void check(const char* tz, DST::Zone& zone, int64_t utc) {
+
+    const time_t t = (time_t)utc;
+    struct tm expected;
+    localtime_r(&t, &expected);
+
+    const int32_t offset = zone.offset(utc);
+    const bool isDST = zone.isDST(utc);
+    checks++;
+    if (offset != expected.tm_gmtoff || isDST != (expected.tm_isdst > 0)) {
+        if (failures < MAX_REPORTS) {
+            printf("FAIL %s at %lld: got offset %d, DST %d; expected offset %ld, DST %d\n",
+                   tz, (long long)utc, offset, isDST, expected.tm_gmtoff, expected.tm_isdst > 0);
+        }
+
+        failures++;
+    }
+}
+
+
+/**
+ * @brief Check one zone over the test period.
+ *
+ * @param tz: The zone's TZ string.
+ */
+static void checkZone(const char* tz) {
+
+    DST::RuleSet rules;
+    checks++;
+    if (!DST::parseTZ(tz, rules)) {
+        printf("FAIL %s: not parsed\n", tz);
+        failures++;
+        return;
+    }
+
+    setenv("TZ", tz, 1);
+    tzset();
+
+    // In time order, as the clock reads it
+    DST::Zone zone(rules);
+    for (int64_t utc = FIRST_SECOND ; utc <= LAST_SECOND ; utc += 3600) check(tz, zone, utc);
+
+    // Either side of each transition, jumping back and forth
+    if (rules.hasDST) {
+        DST::Zone jumpingZone(rules);
+        for (int32_t year = FIRST_YEAR ; year <= LAST_YEAR ; ++year) {
+            const DST::Transitions t = DST::transitions(rules, year);
+            check(tz, jumpingZone, t.start - 1);
+            check(tz, jumpingZone, t.start);
+            check(tz, jumpingZone, t.end - 1);
+            check(tz, jumpingZone, t.end);
+        }
+    }
+}
+
+
+int main(void) {
+
+    for (const char* tz : ZONES) checkZone(tz);
+
+    for (const auto& pair : RULELESS_ZONES) {
+        DST::RuleSet rules, expected;
+        checks++;
+        if (!DST::parseTZ(pair[0], rules) || !DST::parseTZ(pair[1], expected)
+            || rules.stdOffset != expected.stdOffset || rules.dstOffset != expected.dstOffset) {
+            printf("FAIL %s: does not match %s\n", pair[0], pair[1]);
+            failures++;
+            continue;
+        }
+
+        for (int32_t year = FIRST_YEAR ; year <= LAST_YEAR ; ++year) {
+            const DST::Transitions a = DST::transitions(rules, year);
+            const DST::Transitions b = DST::transitions(expected, year);
+            checks++;
+            if (a.start != b.start || a.end != b.end) {
+                if (failures < MAX_REPORTS) printf("FAIL %s: %d transitions do not match %s\n", pair[0], year, pair[1]);
+                failures++;
+            }
+        }
+    }
+
+    for (const char* tz : INVALID_ZONES) {
+        DST::RuleSet rules;
+        checks++;
+        if (DST::parseTZ(tz, rules)) {
+            printf("FAIL \"%s\": parsed, but is invalid\n", tz);
+            failures++;
+        }
+    }
+
+    printf("dst: %llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+/*
+ * Microvisor Clock Demo -- I2C transaction tests
+ *
+ * @author      Tony Smith
+ * @copyright   2024, KORE Wireless
+ * @licence     MIT
+ *
+ * Checks I2C::transact() on the simulated bus when a device stretches
+ * its clock past the timeout: the timed-out read must not write to its
+ * buffer later, nor disturb the outcome of the transactions after it,
+ * which must not wait for it either.
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include "main.h"
+#include "sim.h"
+
+
+/*
+ * CONSTANTS
+ */
+constexpr uint8_t   DEVICE_ADDRESS = 0x50;
+constexpr uint64_t  STRETCH_US = 500000;        // Well beyond readRegister()'s timeout
+
+
+/**
+    A device with a bank of registers, which are read and
+    written from the register pointer, set by the first byte
+    written. It can be made to stretch the clock.
+ */
+class RegisterDevice : public Sim::I2CDevice {
+
+    public:
+        explicit            RegisterDevice(uint8_t address) : Sim::I2CDevice(address) {}
+        void                start([[maybe_unused]] bool isRead) override { isFirstByte = true; }
+        bool                write(uint8_t byte) override {
+                                if (isFirstByte) {
+                                    pointer = byte;
+                                    isFirstByte = false;
+                                } else {
+                                    registers[pointer++] = byte;
+                                }
+
+                                return true;
+                            }
+        uint8_t             read(void) override { return registers[pointer++]; }
+        void                stop(void) override {}
+        uint64_t            stretchTime(void) override { return isStretching ? STRETCH_US : 0; }
+
+        uint8_t             registers[256] = {0};
+        bool                isStretching = false;
+
+    private:
+        uint8_t             pointer = 0;
+        bool                isFirstByte = true;
+};
+
+
+/*
+ * GLOBALS
+ */
+static RegisterDevice   device(DEVICE_ADDRESS);
+static uint64_t         checks = 0;
+static uint64_t         failures = 0;
+
+
+/**
+ * @brief Record the outcome of one check.
+ *
+ * @param isGood: Did the check pass?
+ * @param what:   Description of the check.
+ */
+static void check(bool isGood, const char* what) {
+
+    checks++;
+    if (!isGood) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+
+int main(void) {
+
+    Sim::Options options;
+    options.runSeconds = 3600;
+    options.silent = true;
+    Sim::configure(options);
+    Sim::attach(&device);
+    I2C::setup();
+
+    device.registers[0x10] = 0xA1;
+    device.registers[0x11] = 0xA2;
+    device.registers[0x20] = 0xB1;
+    device.registers[0x21] = 0xB2;
+
+    // A read that times out
+    uint8_t stale[2] = { 0xEE, 0xEE };
+    const uint32_t errors = I2C::getErrorCount();
+    device.isStretching = true;
+    check(!I2C::readRegister(DEVICE_ADDRESS, 0x10, stale, 2), "stretched read does not time out");
+    device.isStretching = false;
+
+    // The next transaction is not held up by it, and gets its own outcome
+    uint8_t fresh[2] = { 0, 0 };
+    check(I2C::readRegister(DEVICE_ADDRESS, 0x20, fresh, 2), "read after a timeout fails");
+    check(fresh[0] == 0xB1 && fresh[1] == 0xB2, "read after a timeout gets the wrong data");
+
+    const uint8_t bytes[2] = { 0x30, 0xC1 };
+    const I2C::Op write = { DEVICE_ADDRESS, I2C::OP::WRITE, 2, (uint8_t*)bytes };
+    check(I2C::transact(&write, 1, 100), "write after a timeout fails");
+    check(device.registers[0x30] == 0xC1, "write after a timeout is not made");
+
+    // Nothing arrives for the timed-out read later
+    Sim::advance(2 * STRETCH_US);
+    check(I2C::flush(10), "queue does not empty");
+    check(stale[0] == 0xEE && stale[1] == 0xEE, "timed-out read writes its buffer");
+    check(I2C::getErrorCount() == errors + 1, "timed-out read is not counted as one error");
+
+    // A timeout behind another transaction drops it before it starts
+    device.isStretching = true;
+    check(I2C::writeByte(DEVICE_ADDRESS, 0x40), "stretched write not queued");
+    check(!I2C::readRegister(DEVICE_ADDRESS, 0x10, stale, 2), "queued read does not time out");
+    device.isStretching = false;
+    Sim::advance(2 * STRETCH_US);
+    check(I2C::flush(10), "queue does not empty after a queued timeout");
+    check(stale[0] == 0xEE && stale[1] == 0xEE, "queued timed-out read writes its buffer");
+    check(I2C::readRegister(DEVICE_ADDRESS, 0x20, fresh, 2), "read after a queued timeout fails");
+
+    printf("i2c: %llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
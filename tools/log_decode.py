@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+Decode tokenized log records.
+
+When the app is built with LOG_TOKENIZED=true, each log message is sent
+as '~' followed by a base64-encoded record: a flags byte, the log call's
+token (the offset of its entry in the 'log_formats' ELF section) and the
+raw argument values. Each entry holds the call's argument type codes,
+then its format string, each ending with a zero byte. This tool reads log output on stdin, or from the
+named file, and writes it to stdout with each record replaced by the
+formatted message.
+
+Usage:
+    twilio microvisor:logs:stream <DEVICE_SID> | tools/log_decode.py build/app/microvisor-cpp-clock-demo.elf
+    tools/log_decode.py build/app/microvisor-cpp-clock-demo.elf saved_log.txt
+"""
+
+import base64
+import re
+import struct
+import sys
+
+SECTION_NAME = b"log_formats"
+RECORD_PATTERN = re.compile(r"~([A-Za-z0-9+/]+={0,2})")
+SPEC_PATTERN = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|L|q|j|z|t)?([diuxXocpsfFeEgG%])")
+
+
+def load_formats(elf_path):
+    """
+    Return the contents of the ELF file's 'log_formats' section.
+    """
+    with open(elf_path, "rb") as file:
+        elf = file.read()
+
+    if elf[:4] != b"\x7fELF":
+        sys.exit(f"[ERROR] {elf_path} is not an ELF file")
+
+    is_64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is_64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        header = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_offset = sections[shstrndx][4]
+    for section in sections:
+        name_start = names_offset + section[0]
+        name = elf[name_start:elf.index(b"\0", name_start)]
+        if name == SECTION_NAME:
+            return elf[section[4]:section[4] + section[5]]
+
+    sys.exit(f"[ERROR] {elf_path} has no '{SECTION_NAME.decode()}' section -- was it built with LOG_TOKENIZED=true?")
+
+
+def read_varint(record, index):
+    """
+    Read an unsigned LEB128 varint. Returns the value and the next index.
+    """
+    value = 0
+    shift = 0
+    while True:
+        byte = record[index]
+        index += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80 == 0:
+            return value, index
+
+
+def decode_record(record, formats):
+    """
+    Rebuild a message from a binary record, mirroring encode_args() in logging.c.
+    """
+    flags = record[0]
+    token, index = read_varint(record, 1)
+    if token >= len(formats):
+        return f"[UNKNOWN TOKEN {token}]"
+    types_end = formats.index(b"\0", token)
+    arg_types = formats[token:types_end].decode()
+    format_string = formats[types_end + 1:formats.index(b"\0", types_end + 1)].decode(errors="replace")
+    type_index = 0
+
+    def next_value():
+        """
+        Read the next argument, as its type code says it was encoded.
+        """
+        nonlocal index, type_index
+        arg_type = arg_types[type_index]
+        type_index += 1
+        if arg_type == "f":
+            value, = struct.unpack_from("<d", record, index)
+            index += 8
+            return value
+        value, index = read_varint(record, index)
+        if arg_type in "iI":
+            return (value >> 1) ^ -(value & 1)
+        if arg_type == "s":
+            text = record[index:index + value].decode(errors="replace")
+            index += value
+            return text
+        return value
+
+    def substitute(match):
+        flag_chars, width, precision, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if index >= len(record) or type_index >= len(arg_types):
+            return match.group(0)
+
+        if width == "*":
+            width = str(next_value())
+        if precision == "*":
+            precision = str(next_value())
+        spec = "%" + flag_chars + (width or "") + ("." + precision if precision is not None else "")
+        value = next_value()
+
+        if conversion == "s":
+            return (spec + "s") % value
+        if conversion in "fFeEgG":
+            return (spec + conversion) % float(value)
+        if conversion == "c":
+            return (spec + "c") % chr(value)
+        if conversion == "p":
+            return "0x%x" % value
+        if conversion in "diu":
+            return (spec + "d") % value
+        # Negative values print as two's complement, at the argument's width
+        if value < 0:
+            value &= (1 << (64 if arg_types[type_index - 1] == "I" else 32)) - 1
+        return (spec + conversion) % value
+
+    try:
+        message = SPEC_PATTERN.sub(substitute, format_string)
+    except (IndexError, struct.error, ValueError):
+        message = format_string + " [TRUNCATED]"
+    return ("[ERROR] " if flags & 0x01 else "[DEBUG] ") + message
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(f"Usage: {sys.argv[0]} <app.elf> [log file]")
+
+    formats = load_formats(sys.argv[1])
+    source = open(sys.argv[2], "r") if len(sys.argv) > 2 else sys.stdin
+
+    def replace(match):
+        try:
+            return decode_record(base64.b64decode(match.group(1)), formats)
+        except ValueError:
+            return match.group(0)
+
+    for line in source:
+        sys.stdout.write(RECORD_PATTERN.sub(replace, line))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Report flash and RAM use per module, from a GNU ld map file.
+
+Each input section in the map is counted against the source file it
+came from. Code, constants and initialised data take flash; initialised
+and zeroed data take RAM, so initialised data counts against both.
+Library members are grouped by library unless --members is given.
+
+Usage:
+    tools/mem_report.py build/app/microvisor-cpp-clock-demo.map
+    tools/mem_report.py --members --sort ram build/app/microvisor-cpp-clock-demo.map
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# An input section, with its name given on the same line or the line before:
+#   " .text.main  0x08000100  0x40 CMakeFiles/app.dir/main.cpp.obj"
+INPUT_PATTERN = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+# An output section, likewise: ".data  0x20000000  0x1c load address 0x08005000"
+OUTPUT_PATTERN = re.compile(r"^(\.\S+|\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(\s+load address)?)?")
+LIBRARY_PATTERN = re.compile(r"^(.*?)([^/\\]+\.a)\((.+)\)$")
+
+RAM_ONLY_SECTIONS = (".bss", ".noinit", ".heap", ".stack", "._user_heap_stack", "COMMON")
+OBJECT_SUFFIXES = (".obj", ".o")
+
+
+def module_name(path, show_members):
+    """
+    Turn an input file path into a short module name: the source file
+    for the app's own objects, and the library, or library member.
+    """
+    match = LIBRARY_PATTERN.match(path)
+    if match:
+        library = match.group(2)
+        if library.startswith("lib"):
+            library = library[3:]
+        library = library[:-2]
+        if not show_members:
+            return f"[{library}]"
+        path = match.group(3)
+        prefix = f"[{library}] "
+    else:
+        prefix = ""
+
+    name = os.path.basename(path)
+    for suffix in OBJECT_SUFFIXES:
+        if name.endswith(suffix):
+            name = name[:-len(suffix)]
+            break
+
+    return prefix + name
+
+
+def read_map(map_path, show_members):
+    """
+    Return a dict of module name -> [flash bytes, RAM bytes].
+    """
+    with open(map_path, encoding="utf-8", errors="replace") as file:
+        lines = file.read().splitlines()
+
+    try:
+        start = lines.index("Linker script and memory map") + 1
+    except ValueError:
+        sys.exit(f"[ERROR] {map_path} is not a GNU ld map file")
+
+    modules = {}
+    output_section = ""
+    output_address = 0
+    output_loaded = False       # Is the output section copied from flash at boot?
+    pending_name = None
+
+    for line in lines[start:]:
+        if not line:
+            continue
+
+        if not line[0].isspace():
+            # A new output section. If its name is long, its address
+            # and size are on the next line
+            match = OUTPUT_PATTERN.match(line)
+            output_section = match.group(1)
+            output_address = int(match.group(2), 16) if match.group(2) else None
+            output_loaded = match.group(4) is not None
+            pending_name = None
+            continue
+
+        match = INPUT_PATTERN.match(line)
+        if match and match.group(1) is None and pending_name is None and output_address is None:
+            output_address = int(match.group(2), 16)
+            output_loaded = "load address" in line
+            continue
+
+        if match is None:
+            # An input section's name, with its details on the next line
+            stripped = line.strip()
+            pending_name = stripped if line.startswith(" .") and " " not in stripped else None
+            continue
+
+        name = match.group(1) or pending_name
+        pending_name = None
+        address = int(match.group(2), 16)
+        size = int(match.group(3), 16)
+        source = match.group(4).strip()
+
+        # Skip symbols, linker-generated padding, and output sections
+        # that aren't loaded, such as debug info, which sit at zero
+        if name is None or name == "*fill*" or size == 0:
+            continue
+        if not output_address or address == 0:
+            continue
+
+        module = module_name(source, show_members)
+        usage = modules.setdefault(module, [0, 0])
+        is_ram_only = output_section.startswith(RAM_ONLY_SECTIONS) or name.startswith(RAM_ONLY_SECTIONS)
+        is_data = output_loaded or output_section.startswith(".data")
+        if is_ram_only:
+            usage[1] += size
+        elif is_data:
+            usage[0] += size
+            usage[1] += size
+        else:
+            usage[0] += size
+
+    return modules
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report flash and RAM use per module, from a GNU ld map file.")
+    parser.add_argument("map", help="The linker map file")
+    parser.add_argument("--members", action="store_true", help="List library members separately")
+    parser.add_argument("--sort", choices=("flash", "ram", "name"), default="flash", help="Sort order (default: flash)")
+    args = parser.parse_args()
+
+    modules = read_map(args.map, args.members)
+    if args.sort == "name":
+        rows = sorted(modules.items())
+    else:
+        column = 0 if args.sort == "flash" else 1
+        rows = sorted(modules.items(), key=lambda item: (-item[1][column], item[0]))
+
+    width = max([len(name) for name in modules] + [len("Module")])
+    print(f"{'Module':<{width}}  {'Flash':>8}  {'RAM':>8}")
+    for name, (flash, ram) in rows:
+        if flash or ram:
+            print(f"{name:<{width}}  {flash:>8}  {ram:>8}")
+
+    total_flash = sum(usage[0] for usage in modules.values())
+    total_ram = sum(usage[1] for usage in modules.values())
+    print(f"{'Total':<{width}}  {total_flash:>8}  {total_ram:>8}")
+
+
+if __name__ == "__main__":
+    main()